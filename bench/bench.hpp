@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sve::bench {
+	using Clock = std::chrono::steady_clock;
+
+	template <typename Type>
+	inline void do_not_optimize(Type const& value) {
+#if defined(_MSC_VER)
+		static_cast<void>(*static_cast<char const volatile*>(static_cast<void const*>(&value)));
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	struct Result {
+		std::string name{};
+		std::size_t ops{};
+		double median_ns_per_op{};
+		double min_ns_per_op{};
+	};
+
+	class Runner {
+	public:
+		static constexpr std::size_t repetitions_v{ 15 };
+		static constexpr auto min_rep_time_v = std::chrono::milliseconds{ 5 };
+
+		// times func in repeated batches and reports the median and minimum cost per op,
+		// where ops is the number of operations one call of func performs
+		template <typename Func>
+		void measure(std::string name, std::size_t const ops, Func&& func) {
+			func(); // warm up caches and lazily grown buffers
+
+			auto iterations = std::size_t{ 1 };
+			for (;;) {
+				auto const start = Clock::now();
+				for (auto i = 0uz; i < iterations; ++i) func();
+				if (Clock::now() - start >= min_rep_time_v || iterations >= (1uz << 20)) break;
+				iterations *= 2;
+			}
+
+			auto samples = std::vector<double>{};
+			samples.reserve(repetitions_v);
+			for (auto rep = 0uz; rep < repetitions_v; ++rep) {
+				auto const start = Clock::now();
+				for (auto i = 0uz; i < iterations; ++i) func();
+				auto const elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+				samples.push_back(elapsed / static_cast<double>(iterations * ops));
+			}
+			std::ranges::sort(samples);
+
+			auto result = Result{
+				.name = std::move(name),
+				.ops = ops,
+				.median_ns_per_op = samples[samples.size() / 2],
+				.min_ns_per_op = samples.front()
+			};
+			std::println("{:<48} {:>10} {:>14.3f} {:>14.3f}", result.name, result.ops, result.median_ns_per_op, result.min_ns_per_op);
+			m_results.push_back(std::move(result));
+		}
+
+		[[nodiscard]] std::vector<Result> const& get_results() const { return m_results; }
+
+	private:
+		std::vector<Result> m_results{};
+	};
+
+	struct Benchmark {
+		std::string_view name{};
+		void (*run)(Runner& runner){};
+	};
+
+	inline std::vector<Benchmark>& registry() {
+		static auto ret = std::vector<Benchmark>{};
+		return ret;
+	}
+
+	struct Registrar {
+		Registrar(std::string_view const name, void (*run)(Runner&)) {
+			registry().push_back(Benchmark{ .name = name, .run = run });
+		}
+	};
+}
+
+#define SVE_BENCHMARK(func) static auto const func##_registrar_v = ::sve::bench::Registrar{ #func, func }
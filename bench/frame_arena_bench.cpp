@@ -0,0 +1,37 @@
+#include "bench.hpp"
+#include "frame_arena.hpp"
+#include <format>
+#include <vector>
+
+namespace sve::bench {
+	namespace {
+		// a frame's worth of short-lived containers: a few dozen small lists of varying length
+		constexpr std::size_t lists_per_frame_v{ 64 };
+		constexpr std::size_t max_list_size_v{ 256 };
+
+		template <typename List>
+		void fill_frame(auto&& make_list) {
+			for (auto list_index = 0uz; list_index < lists_per_frame_v; ++list_index) {
+				List list = make_list();
+				auto const size = (list_index * 37) % max_list_size_v + 1;
+				for (auto i = 0uz; i < size; ++i) list.push_back(static_cast<std::uint32_t>(i));
+				do_not_optimize(list.back());
+			}
+		}
+
+		void frame_temporaries(Runner& runner) {
+			runner.measure(std::format("std::vector temporaries lists={}", lists_per_frame_v), lists_per_frame_v, [] {
+				fill_frame<std::vector<std::uint32_t>>([] { return std::vector<std::uint32_t>{}; });
+			});
+
+			auto arena = FrameArena{};
+			auto const arena_frame = [&arena] {
+				arena.reset();
+				fill_frame<std::pmr::vector<std::uint32_t>>([&arena] { return std::pmr::vector<std::uint32_t>{ &arena }; });
+			};
+			runner.measure(std::format("FrameArena temporaries lists={}", lists_per_frame_v), lists_per_frame_v, arena_frame);
+		}
+	}
+
+	SVE_BENCHMARK(frame_temporaries);
+}
@@ -0,0 +1,119 @@
+#include "bench.hpp"
+#include "draw_batcher.hpp"
+#include "resource_buffering.hpp"
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <random>
+
+namespace sve::bench {
+	namespace {
+		constexpr auto instance_counts_v = std::array{ 1'000uz, 100'000uz };
+		// enough distinct inputs per call that the work can't be hoisted out of the timing loop
+		constexpr std::size_t views_per_call_v{ 256 };
+		constexpr std::size_t colors_per_call_v{ 256 };
+
+		[[nodiscard]] std::vector<Transform> make_transforms(std::size_t const count, std::uint32_t const seed) {
+			auto rng = std::mt19937{ seed };
+			auto position = std::uniform_real_distribution<float>{ -10'000.0f, 10'000.0f };
+			auto rotation = std::uniform_real_distribution<float>{ -720.0f, 720.0f };
+			auto scale = std::uniform_real_distribution<float>{ 0.1f, 4.0f };
+			auto ret = std::vector<Transform>(count);
+			for (auto& transform : ret) {
+				transform = Transform{
+					.position = { position(rng), position(rng) },
+					.rotation = rotation(rng),
+					.scale = { scale(rng), scale(rng) }
+				};
+			}
+			return ret;
+		}
+
+		[[nodiscard]] std::vector<Color> make_colors(std::size_t const count) {
+			auto rng = std::mt19937{ 11 };
+			auto ret = std::vector<Color>(count);
+			for (auto& color : ret) {
+				auto const rgba = rng();
+				color = Color(static_cast<std::uint8_t>(rgba), static_cast<std::uint8_t>(rgba >> 8),
+					static_cast<std::uint8_t>(rgba >> 16), static_cast<std::uint8_t>(rgba >> 24));
+			}
+			return ret;
+		}
+
+		// Renderer::update_view without the device: the view UBO is host visible, so the write that
+		// DescriptorBuffer::write_at does once the buffer is big enough is a memcpy into mapped memory
+		void view_update(Runner& runner) {
+			auto const views = make_transforms(views_per_call_v, 3);
+			auto const viewport_size = glm::vec2{ 1920.0f, 1080.0f };
+
+			runner.measure(std::format("Transform::view_matrix n={}", views_per_call_v), views_per_call_v, [&] {
+				for (auto const& view : views) do_not_optimize(view.view_matrix());
+			});
+
+			// stands in for the mapped allocations of every frame in flight
+			auto mapped = Buffered<std::array<std::byte, sizeof(glm::mat4)>>{};
+			runner.measure(std::format("view_projection_matrix + UBO write n={}", views_per_call_v), views_per_call_v, [&] {
+				for (auto i = 0uz; i < views.size(); ++i) {
+					auto const mat_vp = view_projection_matrix(views[i], viewport_size);
+					auto const bytes = std::bit_cast<std::array<std::byte, sizeof(mat_vp)>>(mat_vp);
+					auto& out = mapped[i % mapped.size()];
+					std::memcpy(out.data(), bytes.data(), bytes.size());
+					do_not_optimize(out);
+				}
+			});
+		}
+
+		// the two steps DrawBatcher runs per frame, on one thread: gather the instances of the sorted
+		// items, then evaluate them into the instance ring
+		void instance_packing(Runner& runner) {
+			for (auto const count : instance_counts_v) {
+				auto const transforms = make_transforms(count, 7);
+				auto const colors = make_colors(count);
+
+				auto objects = std::vector<Object>(count);
+				auto items = std::vector<GatherItem>(count);
+				for (auto i = 0uz; i < count; ++i) {
+					objects[i].transform = transforms[i];
+					objects[i].color = colors[i];
+					items[i] = GatherItem{
+						.object = &objects[i],
+						.first_instance = static_cast<std::uint32_t>(i),
+						.texture_index = static_cast<std::uint32_t>(i % 64)
+					};
+				}
+
+				auto soa = TransformSoA{};
+				soa.resize(count);
+				auto packed_colors = std::vector<std::uint32_t>(count);
+				auto texture_indices = std::vector<std::uint32_t>(count);
+				auto out = std::vector<AffineInstance>(count);
+
+				runner.measure(std::format("gather_instances n={}", count), count, [&] {
+					gather_instances(items, soa, packed_colors, texture_indices);
+					do_not_optimize(packed_colors.back());
+				});
+
+				runner.measure(std::format("evaluate AffineInstance n={}", count), count, [&] {
+					soa.evaluate(out, packed_colors, texture_indices);
+					do_not_optimize(out.back());
+				});
+				runner.measure(std::format("evaluate AffineInstance scalar n={}", count), count, [&] {
+					soa.evaluate(out, packed_colors, texture_indices, 0, TransformKernel::Scalar);
+					do_not_optimize(out.back());
+				});
+			}
+		}
+
+		void clear_color(Runner& runner) {
+			auto const colors = make_colors(colors_per_call_v);
+			runner.measure(std::format("Color::to_vk_clear_srgb n={}", colors_per_call_v), colors_per_call_v, [&] {
+				for (auto const& color : colors) do_not_optimize(color.to_vk_clear_srgb());
+			});
+		}
+	}
+
+	SVE_BENCHMARK(view_update);
+	SVE_BENCHMARK(instance_packing);
+	SVE_BENCHMARK(clear_color);
+}
@@ -0,0 +1,69 @@
+#include "bench.hpp"
+#include "job_system.hpp"
+#include "utils/transform_soa.hpp"
+#include <format>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace sve::bench {
+	namespace {
+		[[nodiscard]] std::vector<std::uint32_t> thread_counts() {
+			auto const hardware = std::max(std::thread::hardware_concurrency(), 1u);
+			auto ret = std::vector<std::uint32_t>{};
+			for (auto count = 1u; count < hardware; count *= 2) ret.push_back(count);
+			ret.push_back(hardware);
+			return ret;
+		}
+
+		void job_scheduling(Runner& runner) {
+			static constexpr std::size_t job_count_v{ 1024 };
+			for (auto const threads : thread_counts()) {
+				auto jobs = JobSystem{ JobSystemCreateInfo{ .thread_count = threads } };
+
+				// cost of handing out and completing an empty job
+				auto const noop = [](void const*, std::size_t, std::size_t) {};
+				auto batch = std::vector<Job>(job_count_v);
+				runner.measure(std::format("JobSystem run+wait empty jobs t={}", threads), job_count_v, [&] {
+					auto counter = JobCounter{};
+					for (auto& job : batch) job = Job{ .entry = noop, .counter = &counter };
+					jobs.run(batch, counter);
+					jobs.wait(counter);
+				});
+
+				auto sink = std::vector<std::uint32_t>(job_count_v);
+				runner.measure(std::format("JobSystem parallel_for grain=1 t={}", threads), job_count_v, [&] {
+					jobs.parallel_for(sink.size(), 1, [&](std::size_t const first, std::size_t const count) {
+						for (auto i = first; i < first + count; ++i) ++sink[i];
+					});
+					do_not_optimize(sink.front());
+				});
+			}
+		}
+
+		void job_scaling(Runner& runner) {
+			static constexpr std::size_t transform_count_v{ 1'000'000 };
+			auto rng = std::mt19937{ 11 };
+			auto value = std::uniform_real_distribution<float>{ -1'000.0f, 1'000.0f };
+			auto soa = TransformSoA{};
+			soa.reserve(transform_count_v);
+			for (auto i = 0uz; i < transform_count_v; ++i) {
+				soa.push_back(Transform{ .position = { value(rng), value(rng) }, .rotation = value(rng), .scale = { 1.0f, 2.0f } });
+			}
+			auto out = std::vector<glm::mat4>(transform_count_v);
+
+			for (auto const threads : thread_counts()) {
+				auto jobs = JobSystem{ JobSystemCreateInfo{ .thread_count = threads } };
+				runner.measure(std::format("TransformSoA parallel n={} t={}", transform_count_v, threads), transform_count_v, [&] {
+					jobs.parallel_for(transform_count_v, 16384, [&](std::size_t const first, std::size_t const count) {
+						soa.evaluate(std::span{ out }.subspan(first, count), first);
+					});
+					do_not_optimize(out.back());
+				});
+			}
+		}
+	}
+
+	SVE_BENCHMARK(job_scheduling);
+	SVE_BENCHMARK(job_scaling);
+}
@@ -0,0 +1,24 @@
+#include "bench.hpp"
+#include <cstdlib>
+#include <exception>
+#include <print>
+#include <span>
+
+int main(int argc, char** argv) {
+	// optional argument: only run benchmarks whose name contains it
+	auto const args = std::span{ argv, static_cast<std::size_t>(argc) };
+	auto const filter = args.size() > 1 ? std::string_view{ args[1] } : std::string_view{};
+
+	try {
+		auto runner = sve::bench::Runner{};
+		std::println("{:<48} {:>10} {:>14} {:>14}", "benchmark", "ops", "median ns/op", "min ns/op");
+		for (auto const& benchmark : sve::bench::registry()) {
+			if (!filter.empty() && !benchmark.name.contains(filter)) continue;
+			benchmark.run(runner);
+		}
+	}
+	catch (std::exception const& e) {
+		std::println(stderr, "PANIC: {}", e.what());
+		return EXIT_FAILURE;
+	}
+}
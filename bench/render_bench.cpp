@@ -0,0 +1,368 @@
+#include "report.hpp"
+#include "engine.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <format>
+#include <new>
+#include <optional>
+#include <print>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string_view>
+
+namespace {
+	// counted to report heap allocations per frame, the renderer should make none in steady state
+	std::atomic<std::uint64_t> heap_allocations{};
+}
+
+void* operator new(std::size_t const size) {
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (auto* ret = std::malloc(size == 0 ? 1 : size)) return ret;
+	throw std::bad_alloc{};
+}
+
+// the array and nothrow forms forward to these two by default
+void* operator new(std::size_t const size, std::align_val_t const alignment) {
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	auto const align = static_cast<std::size_t>(alignment);
+	// aligned_alloc wants a multiple of the alignment
+	if (auto* ret = std::aligned_alloc(align, (std::max(size, 1uz) + align - 1) / align * align)) return ret;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t /*size*/) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t /*size*/, std::align_val_t /*alignment*/) noexcept { std::free(ptr); }
+
+namespace sve::bench {
+	namespace {
+		using Clock = std::chrono::steady_clock;
+
+		struct Options {
+			std::string_view scene_filter{};
+			// set when any scene parameter is given, replaces the suite with a single "custom" scene
+			std::optional<SceneParams> custom{};
+			std::uint32_t frames{ 500 };
+			std::uint32_t warmup{ 50 };
+			glm::ivec2 size{ 1280, 720 };
+			std::string_view format{ "json" };
+			std::string_view out{};
+			std::string_view label{};
+		};
+
+		struct NamedScene {
+			std::string_view name{};
+			SceneParams params{};
+		};
+
+		// fixed so results stay comparable across commits, append rather than change entries
+		constexpr auto suite_v = std::array{
+			NamedScene{ .name = "sprites_1k_static", .params = { .sprites = 1'000 } },
+			NamedScene{ .name = "sprites_10k_static", .params = { .sprites = 10'000 } },
+			NamedScene{ .name = "sprites_10k_animated", .params = { .sprites = 10'000, .animated = true } },
+			NamedScene{ .name = "textures_10k_64", .params = { .sprites = 10'000, .textures = 64 } },
+			NamedScene{ .name = "shaders_10k_8", .params = { .sprites = 10'000, .shaders = 8 } },
+			NamedScene{ .name = "mixed_100k_animated", .params = { .sprites = 100'000, .textures = 64, .shaders = 8, .animated = true } },
+			NamedScene{ .name = "gpu_scene_50k_static", .params = { .sprites = 50'000, .textures = 64, .gpu_scene = true } },
+			NamedScene{ .name = "gpu_scene_10k_animated", .params = { .sprites = 10'000, .textures = 64, .animated = true, .gpu_scene = true } },
+		};
+
+		constexpr std::uint32_t seed_v{ 42 };
+		constexpr float sprite_size_v{ 16.0f };
+		constexpr int texture_size_v{ 4 };
+
+		constexpr auto sprite_vertices_v = std::array{
+			Vertex{.position = { -0.5f * sprite_size_v, -0.5f * sprite_size_v }, .uv = { 0.0f, 1.0f } },
+			Vertex{.position = {  0.5f * sprite_size_v, -0.5f * sprite_size_v }, .uv = { 1.0f, 1.0f } },
+			Vertex{.position = {  0.5f * sprite_size_v,  0.5f * sprite_size_v }, .uv = { 1.0f, 0.0f } },
+			Vertex{.position = { -0.5f * sprite_size_v,  0.5f * sprite_size_v }, .uv = { 0.0f, 0.0f } },
+		};
+		constexpr auto sprite_indices_v = std::array{ 0u, 1u, 2u, 2u, 3u, 0u };
+
+		template <typename Type>
+		[[nodiscard]] Type parse_number(std::string_view const arg, std::string_view const text) {
+			auto ret = Type{};
+			auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), ret);
+			if (error != std::errc{} || end != text.data() + text.size()) {
+				throw std::runtime_error{ std::format("Invalid value for {}: '{}'", arg, text) };
+			}
+			return ret;
+		}
+
+		[[nodiscard]] Options parse_args(std::span<char const* const> const args) {
+			auto ret = Options{};
+			auto const custom = [&ret]() -> SceneParams& {
+				if (!ret.custom) ret.custom.emplace(SceneParams{ .sprites = 10'000 });
+				return *ret.custom;
+				};
+			for (auto i = 0uz; i < args.size(); ++i) {
+				auto const arg = std::string_view{ args[i] };
+				auto const value = [&] {
+					if (++i >= args.size()) throw std::runtime_error{ std::format("Missing value for {}", arg) };
+					return std::string_view{ args[i] };
+					};
+				if (arg == "--scene") ret.scene_filter = value();
+				else if (arg == "--sprites") custom().sprites = parse_number<std::uint32_t>(arg, value());
+				else if (arg == "--textures") custom().textures = std::max(parse_number<std::uint32_t>(arg, value()), 1u);
+				else if (arg == "--shaders") custom().shaders = std::max(parse_number<std::uint32_t>(arg, value()), 1u);
+				else if (arg == "--animated") custom().animated = true;
+				else if (arg == "--gpu-scene") custom().gpu_scene = true;
+				else if (arg == "--frames") ret.frames = std::max(parse_number<std::uint32_t>(arg, value()), 1u);
+				else if (arg == "--warmup") ret.warmup = parse_number<std::uint32_t>(arg, value());
+				else if (arg == "--width") ret.size.x = parse_number<int>(arg, value());
+				else if (arg == "--height") ret.size.y = parse_number<int>(arg, value());
+				else if (arg == "--format") ret.format = value();
+				else if (arg == "--out") ret.out = value();
+				else if (arg == "--label") ret.label = value();
+				else throw std::runtime_error{ std::format("Unknown argument '{}'", arg) };
+			}
+			if (ret.format != "json" && ret.format != "csv") throw std::runtime_error{ std::format("Unknown format '{}', expected json or csv", ret.format) };
+			return ret;
+		}
+
+		// owns what a scene registered and the objects the renderer points at
+		class Scene {
+		public:
+			Scene(Engine& engine, SceneParams const& params, glm::ivec2 const size)
+				: m_renderer(engine.get_renderer()), m_params(params), m_gpu_scene(params.gpu_scene ? m_renderer.get_gpu_scene() : nullptr) {
+				if (params.gpu_scene && !m_gpu_scene) throw std::runtime_error{ "GPU scene unavailable on this device" };
+				auto rng = std::mt19937{ seed_v };
+				auto& resources = m_renderer.get_resources();
+
+				m_mesh = m_renderer.create_mesh(sprite_vertices_v, sprite_indices_v);
+
+				m_sampler = m_renderer.create_sampler(vk::SamplerCreateInfo{ sampler_ci_v }.setMagFilter(vk::Filter::eNearest));
+				auto byte = std::uniform_int_distribution<int>{ 0, 255 };
+				auto pixels = std::vector<std::byte>(static_cast<std::size_t>(4 * texture_size_v * texture_size_v));
+				for (auto i = 0u; i < params.textures; ++i) {
+					for (auto& pixel : pixels) pixel = static_cast<std::byte>(byte(rng));
+					auto const bitmap = Bitmap{ .bytes = pixels, .size = { texture_size_v, texture_size_v } };
+					m_textures.push_back(engine.create_texture(bitmap, *resources.get(m_sampler)));
+				}
+				// distinct shader objects of the same program, every switch rebinds
+				for (auto i = 0u; i < params.shaders; ++i) m_shaders.push_back(engine.create_shader_program());
+
+				auto const half_size = 0.5f * glm::vec2{ size };
+				auto x = std::uniform_real_distribution<float>{ -half_size.x, half_size.x };
+				auto y = std::uniform_real_distribution<float>{ -half_size.y, half_size.y };
+				auto angle = std::uniform_real_distribution<float>{ 0.0f, 360.0f };
+				auto scale = std::uniform_real_distribution<float>{ 0.5f, 2.0f };
+				auto texture = std::uniform_int_distribution<std::size_t>{ 0, m_textures.size() - 1 };
+				auto shader = std::uniform_int_distribution<std::size_t>{ 0, m_shaders.size() - 1 };
+				// the renderer keeps pointers, the vector must never reallocate
+				m_objects.resize(params.sprites);
+				m_velocities.resize(params.animated ? params.sprites : 0);
+				for (auto [index, object] : std::views::enumerate(m_objects)) {
+					object.mesh = m_mesh;
+					object.material = Material{ .shader = m_shaders[shader(rng)], .texture = m_textures[texture(rng)] };
+					object.transform = Transform{ .position = { x(rng), y(rng) }, .rotation = angle(rng), .scale = glm::vec2{ scale(rng) } };
+					object.color = Color(static_cast<std::uint8_t>(byte(rng)), static_cast<std::uint8_t>(byte(rng)), static_cast<std::uint8_t>(byte(rng)));
+					if (params.animated) m_velocities[static_cast<std::size_t>(index)] = glm::vec2{ x(rng), y(rng) } * 0.01f;
+					if (m_gpu_scene) m_gpu_ids.push_back(m_gpu_scene->add(object));
+					else m_renderer.add(object);
+				}
+				m_half_size = half_size;
+			}
+
+			Scene(Scene const&) = delete;
+			Scene& operator=(Scene const&) = delete;
+			Scene(Scene&&) = delete;
+			Scene& operator=(Scene&&) = delete;
+
+			~Scene() {
+				if (m_gpu_scene) {
+					for (auto const id : m_gpu_ids) m_gpu_scene->remove(id);
+				}
+				else {
+					for (auto& object : m_objects) m_renderer.remove(object);
+				}
+				m_renderer.destroy(m_mesh);
+				for (auto const texture : m_textures) m_renderer.destroy(texture);
+				for (auto const shader : m_shaders) m_renderer.destroy(shader);
+				m_renderer.destroy(m_sampler);
+			}
+
+			// bounces sprites inside the view so the visible count stays constant
+			void animate() {
+				if (!m_params.animated) return;
+				for (auto [index, object, velocity] : std::views::zip(std::views::iota(0uz), m_objects, m_velocities)) {
+					auto& position = object.transform.position;
+					position += velocity;
+					if (std::abs(position.x) > m_half_size.x) velocity.x = -velocity.x;
+					if (std::abs(position.y) > m_half_size.y) velocity.y = -velocity.y;
+					object.transform.rotation += 1.0f;
+					if (m_gpu_scene) m_gpu_scene->update(m_gpu_ids[index], object);
+					else m_renderer.update(object);
+				}
+			}
+
+		private:
+			Renderer& m_renderer;
+			SceneParams m_params{};
+			GpuScene* m_gpu_scene{};
+			glm::vec2 m_half_size{};
+			MeshHandle m_mesh{};
+			SamplerHandle m_sampler{};
+			std::vector<TextureHandle> m_textures{};
+			std::vector<ShaderHandle> m_shaders{};
+			std::vector<Object> m_objects{};
+			// parallel to m_objects in GPU scenes
+			std::vector<std::uint32_t> m_gpu_ids{};
+			std::vector<glm::vec2> m_velocities{};
+		};
+
+		[[nodiscard]] SceneResult run_scene(Engine& engine, NamedScene const& named, Options const& options) {
+			auto& renderer = engine.get_renderer();
+			auto scene = Scene{ engine, named.params, options.size };
+
+			auto cpu_ms = std::vector<double>{};
+			auto frame_ms = std::vector<double>{};
+			auto gpu_ms = std::vector<double>{};
+			auto allocations = std::vector<double>{};
+			for (auto* samples : { &cpu_ms, &frame_ms, &gpu_ms, &allocations }) samples->reserve(options.frames);
+
+			auto previous = Clock::now();
+			for (auto frame = 0u; frame < options.warmup + options.frames; ++frame) {
+				renderer.pace_frame();
+				// moving objects updates the spatial index, which must not allocate either
+				auto const allocations_before = heap_allocations.load(std::memory_order_relaxed);
+				scene.animate();
+				auto const start = Clock::now();
+				renderer.draw(Color(10, 10, 10));
+				auto const end = Clock::now();
+				auto const allocated = heap_allocations.load(std::memory_order_relaxed) - allocations_before;
+				auto const frame_time = end - std::exchange(previous, end);
+				if (frame < options.warmup) continue;
+
+				cpu_ms.push_back(std::chrono::duration<double, std::milli>{ end - start }.count());
+				frame_ms.push_back(std::chrono::duration<double, std::milli>{ frame_time }.count());
+				gpu_ms.push_back(renderer.get_stats().gpu_ms);
+				allocations.push_back(static_cast<double>(allocated));
+			}
+			renderer.get_frame_timeline().wait_idle();
+
+			auto const memory_stats = renderer.get_memory_stats();
+			auto gpu_allocations = 0u;
+			for (auto const& category : memory_stats.categories) gpu_allocations += category.allocations;
+
+			auto ret = SceneResult{
+				.name = std::string{ named.name },
+				.params = named.params,
+				.frames = options.frames,
+				.cpu_ms = get_percentiles(std::move(cpu_ms)),
+				.frame_ms = get_percentiles(std::move(frame_ms)),
+				.gpu_ms = get_percentiles(std::move(gpu_ms)),
+				.heap_allocations = get_percentiles(std::move(allocations)),
+				.gpu_allocations = gpu_allocations
+			};
+			std::println(stderr, "{:<24} cpu p50 {:.3f} ms, frame p50 {:.3f} ms, gpu p50 {:.3f} ms, {:.0f} allocations p50",
+				ret.name, ret.cpu_ms.p50, ret.frame_ms.p50, ret.gpu_ms.p50, ret.heap_allocations.p50);
+			return ret;
+		}
+
+		// adds GPU scene objects with a fresh mesh and shader every frame, then removes them and destroys
+		// both. throws if the scene still uses destroyed handles or keeps draws it no longer needs
+		void check_gpu_scene_churn(Engine& engine, GpuScene& gpu_scene) {
+			// more than GpuScene's default draw limit, so released draws must be reused
+			static constexpr auto cycles_v = 300u;
+			static constexpr auto objects_v = 4u;
+
+			auto& renderer = engine.get_renderer();
+			auto const sampler = renderer.create_sampler(vk::SamplerCreateInfo{ sampler_ci_v });
+			auto const pixels = std::array<std::byte, 4 * texture_size_v * texture_size_v>{};
+			auto const texture = engine.create_texture(Bitmap{ .bytes = pixels, .size = { texture_size_v, texture_size_v } }, *renderer.get_resources().get(sampler));
+
+			auto objects = std::array<Object, objects_v>{};
+			auto ids = std::array<std::uint32_t, objects_v>{};
+			for (auto cycle = 0u; cycle < cycles_v; ++cycle) {
+				auto const mesh = renderer.create_mesh(sprite_vertices_v, sprite_indices_v);
+				auto const shader = engine.create_shader_program();
+				for (auto [index, object, id] : std::views::zip(std::views::iota(0u), objects, ids)) {
+					object.mesh = mesh;
+					object.material = Material{ .shader = shader, .texture = texture };
+					object.transform.position = { sprite_size_v * static_cast<float>(index), 0.0f };
+					id = gpu_scene.add(object);
+				}
+				renderer.pace_frame();
+				renderer.draw(Color(10, 10, 10));
+
+				for (auto const id : ids) gpu_scene.remove(id);
+				renderer.destroy(mesh);
+				renderer.destroy(shader);
+			}
+			renderer.destroy(texture);
+			renderer.destroy(sampler);
+			std::println(stderr, "{:<24} ok, {} cycles", "gpu_scene_churn", cycles_v);
+		}
+
+		// false if a scene allocated in a measured frame, the renderer must reuse everything once warm
+		[[nodiscard]] bool run(Options const& options) {
+			auto const engine_ci = Engine::CreateInfo{ .headless = true, .headless_size = options.size };
+			auto engine = Engine{ engine_ci };
+			engine.init();
+
+			auto report = Report{
+				.label = std::string{ options.label },
+				.device = std::string{ engine.get_gpu().properties.deviceName.data() },
+				.width = static_cast<std::uint32_t>(options.size.x),
+				.height = static_cast<std::uint32_t>(options.size.y),
+				.gpu_timestamps = engine.get_renderer().has_gpu_timestamps()
+			};
+			if (options.custom) {
+				report.scenes.push_back(run_scene(engine, NamedScene{ .name = "custom", .params = *options.custom }, options));
+			}
+			else {
+				if (auto* gpu_scene = engine.get_renderer().get_gpu_scene(); gpu_scene && std::string_view{ "gpu_scene_churn" }.contains(options.scene_filter)) {
+					check_gpu_scene_churn(engine, *gpu_scene);
+				}
+				for (auto const& scene : suite_v) {
+					if (!options.scene_filter.empty() && !scene.name.contains(options.scene_filter)) continue;
+					if (scene.params.gpu_scene && !engine.get_renderer().get_gpu_scene()) {
+						std::println(stderr, "{:<24} skipped, GPU scene unavailable", scene.name);
+						continue;
+					}
+					report.scenes.push_back(run_scene(engine, scene, options));
+				}
+			}
+
+			auto file = std::ofstream{};
+			if (!options.out.empty()) {
+				file.open(std::string{ options.out });
+				if (!file.is_open()) throw std::runtime_error{ std::format("Failed to open '{}'", options.out) };
+			}
+			auto& out = options.out.empty() ? std::cout : file;
+			if (options.format == "csv") write_csv(out, report);
+			else write_json(out, report);
+
+			auto ret = true;
+			for (auto const& scene : report.scenes) {
+				if (scene.heap_allocations.max == 0.0) continue;
+				std::println(stderr, "{}: {:.0f} heap allocations in a steady state frame, expected none", scene.name, scene.heap_allocations.max);
+				ret = false;
+			}
+			return ret;
+		}
+	}
+}
+
+// headless rendering benchmark, progress goes to stderr and the report to stdout or --out.
+// exits with failure when a scene allocates from the heap in a measured frame
+int main(int argc, char** argv) {
+	try {
+		auto const args = std::span{ argv, static_cast<std::size_t>(argc) };
+		if (!sve::bench::run(sve::bench::parse_args(args.subspan(1)))) return EXIT_FAILURE;
+	}
+	catch (std::exception const& e) {
+		std::println(stderr, "PANIC: {}", e.what());
+		return EXIT_FAILURE;
+	}
+}
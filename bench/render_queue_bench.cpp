@@ -0,0 +1,71 @@
+#include "bench.hpp"
+#include "render_queue.hpp"
+#include <array>
+#include <format>
+#include <random>
+#include <ranges>
+#include <tuple>
+
+namespace sve::bench {
+	namespace {
+		constexpr auto submission_counts_v = std::array{ 1'000uz, 10'000uz, 50'000uz, 100'000uz };
+
+		struct Submission {
+			DrawKeyFields fields{};
+		};
+
+		[[nodiscard]] std::vector<Submission> make_submissions(std::size_t const count) {
+			auto rng = std::mt19937{ 42 };
+			auto ret = std::vector<Submission>(count);
+			for (auto& submission : ret) {
+				submission.fields = DrawKeyFields{
+					.layer = static_cast<std::uint8_t>(rng() % 4),
+					.translucent = rng() % 4 == 0,
+					.shader = rng() % 8,
+					.texture = rng() % 64,
+					.mesh = rng() % 16,
+					.depth = std::uniform_real_distribution<float>{}(rng)
+				};
+			}
+			return ret;
+		}
+
+		[[nodiscard]] auto compare_key(Submission const& submission) {
+			auto const& f = submission.fields;
+			return std::tuple{
+				f.layer, f.translucent, f.translucent ? -f.depth : 0.0f,
+				f.shader, f.texture, f.mesh, f.translucent ? 0.0f : f.depth
+			};
+		}
+
+		void render_queue_sort(Runner& runner) {
+			for (auto const count : submission_counts_v) {
+				auto const submissions = make_submissions(count);
+
+				auto items = std::vector<RenderItem>(count);
+				auto scratch = std::vector<RenderItem>(count);
+				runner.measure(std::format("radix_sort (encode + sort) n={}", count), count, [&] {
+					for (auto const [index, submission] : std::views::enumerate(submissions)) {
+						items[static_cast<std::size_t>(index)] = RenderItem{
+							.key = encode_draw_key(submission.fields),
+							.payload = static_cast<std::uint32_t>(index)
+						};
+					}
+					radix_sort(items, scratch);
+					do_not_optimize(items.front());
+				});
+
+				auto pointers = std::vector<Submission const*>(count);
+				runner.measure(std::format("std::sort over pointers n={}", count), count, [&] {
+					for (auto const [index, submission] : std::views::enumerate(submissions)) {
+						pointers[static_cast<std::size_t>(index)] = &submission;
+					}
+					std::ranges::sort(pointers, {}, [](Submission const* s) { return compare_key(*s); });
+					do_not_optimize(pointers.front());
+				});
+			}
+		}
+	}
+
+	SVE_BENCHMARK(render_queue_sort);
+}
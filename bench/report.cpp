@@ -0,0 +1,112 @@
+#include "report.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <ranges>
+#include <string_view>
+
+namespace sve::bench {
+	namespace {
+		struct Metric {
+			std::string_view name{};
+			Percentiles SceneResult::* percentiles{};
+		};
+
+		constexpr auto metrics_v = std::array{
+			Metric{ .name = "cpu_ms", .percentiles = &SceneResult::cpu_ms },
+			Metric{ .name = "frame_ms", .percentiles = &SceneResult::frame_ms },
+			Metric{ .name = "gpu_ms", .percentiles = &SceneResult::gpu_ms },
+			Metric{ .name = "heap_allocations", .percentiles = &SceneResult::heap_allocations },
+		};
+
+		[[nodiscard]] std::string escape_json(std::string_view const in) {
+			auto ret = std::string{};
+			ret.reserve(in.size());
+			for (char const c : in) {
+				if (c == '"' || c == '\\') ret.push_back('\\');
+				if (static_cast<unsigned char>(c) < 0x20) ret += std::format("\\u{:04x}", static_cast<unsigned>(c));
+				else ret.push_back(c);
+			}
+			return ret;
+		}
+
+		[[nodiscard]] std::string escape_csv(std::string_view const in) {
+			if (in.find_first_of(",\"\n") == std::string_view::npos) return std::string{ in };
+			auto ret = std::string{ "\"" };
+			for (char const c : in) {
+				if (c == '"') ret.push_back('"');
+				ret.push_back(c);
+			}
+			ret.push_back('"');
+			return ret;
+		}
+
+		[[nodiscard]] std::string to_json(Percentiles const& in) {
+			return std::format(R"({{ "p50": {:.4f}, "p90": {:.4f}, "p99": {:.4f}, "max": {:.4f}, "mean": {:.4f} }})", in.p50, in.p90, in.p99, in.max, in.mean);
+		}
+	}
+
+	Percentiles get_percentiles(std::vector<double> samples) {
+		if (samples.empty()) return {};
+		std::ranges::sort(samples);
+		auto const at = [&samples](double const percentile) {
+			auto const rank = static_cast<std::size_t>(std::ceil(percentile * static_cast<double>(samples.size())));
+			return samples[std::clamp(rank, 1uz, samples.size()) - 1];
+			};
+		return Percentiles{
+			.p50 = at(0.5),
+			.p90 = at(0.9),
+			.p99 = at(0.99),
+			.max = samples.back(),
+			.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size())
+		};
+	}
+
+	void write_json(std::ostream& out, Report const& report) {
+		out << std::format(R"({{
+  "label": "{}",
+  "device": "{}",
+  "width": {},
+  "height": {},
+  "gpu_timestamps": {},
+  "scenes": [)", escape_json(report.label), escape_json(report.device), report.width, report.height, report.gpu_timestamps);
+		for (auto const& [index, scene] : std::views::enumerate(report.scenes)) {
+			out << (index == 0 ? "\n" : ",\n");
+			out << std::format(R"(    {{
+      "name": "{}",
+      "sprites": {},
+      "textures": {},
+      "shaders": {},
+      "animated": {},
+      "gpu_scene": {},
+      "frames": {},
+)", escape_json(scene.name), scene.params.sprites, scene.params.textures, scene.params.shaders, scene.params.animated, scene.params.gpu_scene, scene.frames);
+			for (auto const& metric : metrics_v) {
+				out << std::format("      \"{}\": {},\n", metric.name, to_json(scene.*metric.percentiles));
+			}
+			out << std::format("      \"gpu_allocations\": {}\n    }}", scene.gpu_allocations);
+		}
+		out << "\n  ]\n}\n";
+	}
+
+	void write_csv(std::ostream& out, Report const& report) {
+		out << "label,device,width,height,scene,sprites,textures,shaders,animated,gpu_scene,frames";
+		for (auto const& metric : metrics_v) {
+			for (auto const percentile : { "p50", "p90", "p99", "max", "mean" }) out << std::format(",{}_{}", metric.name, percentile);
+		}
+		out << ",gpu_allocations\n";
+
+		for (auto const& scene : report.scenes) {
+			out << std::format("{},{},{},{},{},{},{},{},{},{},{}", escape_csv(report.label), escape_csv(report.device), report.width, report.height,
+				escape_csv(scene.name), scene.params.sprites, scene.params.textures, scene.params.shaders, scene.params.animated ? 1 : 0,
+				scene.params.gpu_scene ? 1 : 0, scene.frames);
+			for (auto const& metric : metrics_v) {
+				auto const& p = scene.*metric.percentiles;
+				out << std::format(",{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}", p.p50, p.p90, p.p99, p.max, p.mean);
+			}
+			out << std::format(",{}\n", scene.gpu_allocations);
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sve::bench {
+	struct Percentiles {
+		double p50{};
+		double p90{};
+		double p99{};
+		double max{};
+		double mean{};
+	};
+
+	// nearest rank percentiles, all zero for no samples
+	[[nodiscard]] Percentiles get_percentiles(std::vector<double> samples);
+
+	struct SceneParams {
+		std::uint32_t sprites{};
+		std::uint32_t textures{ 1 };
+		std::uint32_t shaders{ 1 };
+		// every sprite moves and rotates each frame, static sprites are only culled and drawn
+		bool animated{};
+		// sprites live in the renderer's GpuScene and are culled by the compute pass
+		bool gpu_scene{};
+	};
+
+	struct SceneResult {
+		std::string name{};
+		SceneParams params{};
+		std::uint32_t frames{};
+		// time spent in Renderer::draw, recording and submitting the frame
+		Percentiles cpu_ms{};
+		// time between consecutive frames, including waits for frames in flight
+		Percentiles frame_ms{};
+		Percentiles gpu_ms{};
+		// operator new calls per frame
+		Percentiles heap_allocations{};
+		// live VMA allocations once the scene has run
+		std::uint32_t gpu_allocations{};
+	};
+
+	struct Report {
+		// free form, eg the commit being measured
+		std::string label{};
+		std::string device{};
+		std::uint32_t width{};
+		std::uint32_t height{};
+		// gpu_ms is all zero without
+		bool gpu_timestamps{};
+		std::vector<SceneResult> scenes{};
+	};
+
+	void write_json(std::ostream& out, Report const& report);
+	// one row per scene, metrics flattened into <metric>_<percentile> columns
+	void write_csv(std::ostream& out, Report const& report);
+}
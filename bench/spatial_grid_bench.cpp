@@ -0,0 +1,75 @@
+#include "bench.hpp"
+#include "spatial_grid.hpp"
+#include <format>
+#include <random>
+
+namespace sve::bench {
+	namespace {
+		constexpr std::size_t object_count_v{ 1'000'000 };
+		// a 1M object world roughly 100 x 100 views of 1920x1080 across
+		constexpr float world_extent_v{ 100'000.0f };
+		constexpr float view_width_v{ 1920.0f };
+		constexpr float view_height_v{ 1080.0f };
+
+		[[nodiscard]] std::vector<Rect> make_bounds(std::size_t const count, std::mt19937& rng) {
+			auto position = std::uniform_real_distribution<float>{ -world_extent_v, world_extent_v };
+			auto size = std::uniform_real_distribution<float>{ 8.0f, 256.0f };
+			auto ret = std::vector<Rect>(count);
+			for (auto& rect : ret) {
+				auto const min = glm::vec2{ position(rng), position(rng) };
+				rect = Rect{ .min = min, .max = min + glm::vec2{ size(rng), size(rng) } };
+			}
+			return ret;
+		}
+
+		void spatial_grid(Runner& runner) {
+			auto rng = std::mt19937{ 5 };
+			auto bounds = make_bounds(object_count_v, rng);
+
+			runner.measure(std::format("SpatialGrid insert n={}", object_count_v), object_count_v, [&] {
+				auto grid = SpatialGrid{};
+				for (auto i = 0uz; i < bounds.size(); ++i) {
+					do_not_optimize(grid.insert(bounds[i], static_cast<std::uint32_t>(i)));
+				}
+			});
+
+			auto grid = SpatialGrid{};
+			auto proxies = std::vector<std::uint32_t>{};
+			proxies.reserve(object_count_v);
+			for (auto i = 0uz; i < bounds.size(); ++i) {
+				proxies.push_back(grid.insert(bounds[i], static_cast<std::uint32_t>(i)));
+			}
+
+			// small per-frame motion, a few percent of the moves cross a cell border
+			auto step = std::uniform_real_distribution<float>{ -4.0f, 4.0f };
+			auto offsets = std::vector<glm::vec2>(object_count_v);
+			for (auto& offset : offsets) offset = { step(rng), step(rng) };
+			auto sign = 1.0f;
+			runner.measure(std::format("SpatialGrid update n={}", object_count_v), object_count_v, [&] {
+				for (auto i = 0uz; i < object_count_v; ++i) {
+					auto& rect = bounds[i];
+					rect.min += offsets[i] * sign;
+					rect.max += offsets[i] * sign;
+					grid.update(proxies[i], rect);
+				}
+				sign = -sign;
+			});
+
+			auto position = std::uniform_real_distribution<float>{ -world_extent_v, world_extent_v - view_width_v };
+			auto views = std::vector<Rect>(256);
+			for (auto& view : views) {
+				auto const min = glm::vec2{ position(rng), position(rng) };
+				view = Rect{ .min = min, .max = min + glm::vec2{ view_width_v, view_height_v } };
+			}
+			auto visible = std::pmr::vector<std::uint32_t>{};
+			auto next_view = 0uz;
+			runner.measure(std::format("SpatialGrid query 1920x1080 n={}", object_count_v), 1, [&] {
+				visible.clear();
+				grid.query(views[next_view++ % views.size()], visible);
+				do_not_optimize(visible.size());
+			});
+		}
+	}
+
+	SVE_BENCHMARK(spatial_grid);
+}
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+#include "utils/transform_soa.hpp"
+#include <array>
+#include <format>
+#include <random>
+
+namespace sve::bench {
+	namespace {
+		constexpr auto transform_counts_v = std::array{ 1'000uz, 100'000uz, 1'000'000uz };
+
+		[[nodiscard]] std::vector<Transform> make_transforms(std::size_t const count) {
+			auto rng = std::mt19937{ 7 };
+			auto position = std::uniform_real_distribution<float>{ -10'000.0f, 10'000.0f };
+			auto rotation = std::uniform_real_distribution<float>{ -720.0f, 720.0f };
+			auto scale = std::uniform_real_distribution<float>{ 0.1f, 4.0f };
+			auto ret = std::vector<Transform>(count);
+			for (auto& transform : ret) {
+				transform = Transform{
+					.position = { position(rng), position(rng) },
+					.rotation = rotation(rng),
+					.scale = { scale(rng), scale(rng) }
+				};
+			}
+			return ret;
+		}
+
+		void transform_evaluation(Runner& runner) {
+			for (auto const count : transform_counts_v) {
+				auto const transforms = make_transforms(count);
+				auto out = std::vector<glm::mat4>(count);
+
+				runner.measure(std::format("Transform::model_matrix n={}", count), count, [&] {
+					for (auto i = 0uz; i < count; ++i) {
+						out[i] = transforms[i].model_matrix();
+					}
+					do_not_optimize(out.back());
+				});
+
+				auto soa = TransformSoA{};
+				soa.reserve(count);
+				for (auto const& transform : transforms) soa.push_back(transform);
+
+				runner.measure(std::format("TransformSoA scalar n={}", count), count, [&] {
+					soa.evaluate(out, 0, TransformKernel::Scalar);
+					do_not_optimize(out.back());
+				});
+				runner.measure(std::format("TransformSoA simd n={}", count), count, [&] {
+					soa.evaluate(out);
+					do_not_optimize(out.back());
+				});
+			}
+		}
+	}
+
+	SVE_BENCHMARK(transform_evaluation);
+}
@@ -0,0 +1,73 @@
+#include "command_recorder.hpp"
+#include "cpu_profiler.hpp"
+#include <algorithm>
+#include <ranges>
+
+namespace sve {
+	CommandRecorder::CommandRecorder(CreateInfo const& create_info) : m_device(create_info.device), m_jobs(create_info.jobs) {
+		auto const thread_count = m_jobs->get_thread_count();
+
+		auto command_pool_ci = vk::CommandPoolCreateInfo{};
+		command_pool_ci.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(create_info.queue_family);
+		m_recorders.resize(thread_count);
+		for (auto& recorder : m_recorders) {
+			for (auto [pool, command_buffer] : std::views::zip(recorder.pools, recorder.command_buffers)) {
+				pool = m_device.createCommandPoolUnique(command_pool_ci);
+				auto command_buffer_ai = vk::CommandBufferAllocateInfo{};
+				command_buffer_ai.setCommandPool(*pool)
+					.setCommandBufferCount(1)
+					.setLevel(vk::CommandBufferLevel::eSecondary);
+				command_buffer = m_device.allocateCommandBuffers(command_buffer_ai).front();
+			}
+		}
+		m_recorded.reserve(thread_count);
+		m_active_threads = thread_count;
+	}
+
+	void CommandRecorder::set_active_threads(std::uint32_t const count) {
+		m_active_threads = std::clamp(count, 1u, get_thread_count());
+	}
+
+	std::size_t CommandRecorder::get_chunk_count(std::size_t const item_count) const {
+		return std::clamp(item_count / min_chunk_size_v, 1uz, std::size_t{ m_active_threads });
+	}
+
+	std::span<vk::CommandBuffer const> CommandRecorder::record(
+		std::size_t const frame_index,
+		vk::CommandBufferInheritanceRenderingInfo const& rendering_info,
+		std::size_t const item_count,
+		RecordChunkFunc const func
+	) {
+		auto const chunk_count = get_chunk_count(item_count);
+		m_recorded.clear();
+		for (auto i = 0uz; i < chunk_count; ++i) {
+			auto const& recorder = m_recorders.at(i);
+			m_device.resetCommandPool(*recorder.pools.at(frame_index));
+			m_recorded.push_back(recorder.command_buffers.at(frame_index));
+		}
+
+		auto inheritance_info = vk::CommandBufferInheritanceInfo{};
+		inheritance_info.setPNext(&rendering_info);
+		auto command_buffer_bi = vk::CommandBufferBeginInfo{};
+		command_buffer_bi.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue)
+			.setPInheritanceInfo(&inheritance_info);
+
+		auto const chunk_size = item_count / chunk_count;
+		auto const remainder = item_count % chunk_count;
+		auto const record_chunks = [&](std::size_t const first_chunk, std::size_t const count) {
+			for (auto chunk = first_chunk; chunk < first_chunk + count; ++chunk) {
+				SVE_PROFILE_ZONE("Record chunk");
+				// the first `remainder` chunks take one extra item
+				auto const first = chunk * chunk_size + std::min(chunk, remainder);
+				auto const size = chunk_size + (chunk < remainder ? 1 : 0);
+				auto const command_buffer = m_recorded[chunk];
+				command_buffer.begin(command_buffer_bi);
+				func(command_buffer, chunk, first, size);
+				command_buffer.end();
+			}
+			};
+		m_jobs->parallel_for(chunk_count, 1, record_chunks);
+		return m_recorded;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "resource_buffering.hpp"
+#include "job_system.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sve {
+	struct CommandRecorderCreateInfo {
+		vk::Device device{};
+		std::uint32_t queue_family{};
+		JobSystem* jobs{};
+	};
+
+	// records [first, first + count) of the draw list for chunk_index into a secondary command buffer.
+	// Refers to the callable instead of owning it like std::function, so binding a capturing lambda never allocates.
+	class RecordChunkFunc {
+	public:
+		template <typename Func>
+		RecordChunkFunc(Func const& func)
+			: m_context(&func),
+			m_entry([](void const* context, vk::CommandBuffer const command_buffer, std::size_t const chunk_index, std::size_t const first, std::size_t const count) {
+				(*static_cast<Func const*>(context))(command_buffer, chunk_index, first, count);
+			}) {}
+
+		void operator()(vk::CommandBuffer const command_buffer, std::size_t const chunk_index, std::size_t const first, std::size_t const count) const {
+			m_entry(m_context, command_buffer, chunk_index, first, count);
+		}
+
+	private:
+		void const* m_context{};
+		void (*m_entry)(void const* context, vk::CommandBuffer command_buffer, std::size_t chunk_index, std::size_t first, std::size_t count){};
+	};
+
+	// Splits a draw list into contiguous chunks recorded as jobs into secondary command buffers.
+	// Every chunk slot owns a command pool per frame in flight and a chunk is recorded by one
+	// thread at a time, so recording never shares a pool.
+	class CommandRecorder {
+	public:
+		using CreateInfo = CommandRecorderCreateInfo;
+
+		// chunks smaller than this are not worth a secondary command buffer
+		static constexpr std::size_t min_chunk_size_v{ 64 };
+
+		explicit CommandRecorder(CreateInfo const& create_info);
+
+		[[nodiscard]] std::size_t get_chunk_count(std::size_t item_count) const;
+
+		// the returned command buffers are in draw list order and stay valid until frame_index comes around again
+		[[nodiscard]] std::span<vk::CommandBuffer const> record(
+			std::size_t frame_index,
+			vk::CommandBufferInheritanceRenderingInfo const& rendering_info,
+			std::size_t item_count,
+			RecordChunkFunc func
+		);
+
+		[[nodiscard]] std::uint32_t get_thread_count() const { return static_cast<std::uint32_t>(m_recorders.size()); }
+		[[nodiscard]] std::uint32_t get_active_threads() const { return m_active_threads; }
+		void set_active_threads(std::uint32_t count);
+
+	private:
+		struct ChunkRecorder {
+			Buffered<vk::UniqueCommandPool> pools{};
+			Buffered<vk::CommandBuffer> command_buffers{};
+		};
+
+		vk::Device m_device{};
+		JobSystem* m_jobs{};
+		std::vector<ChunkRecorder> m_recorders{};
+		std::vector<vk::CommandBuffer> m_recorded{};
+		std::uint32_t m_active_threads{};
+	};
+}
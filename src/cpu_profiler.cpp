@@ -0,0 +1,202 @@
+#include "cpu_profiler.hpp"
+
+#if SVE_CPU_PROFILER
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <utility>
+#include <vector>
+
+namespace sve::cpu_profiler {
+	namespace {
+		// per thread, about 1000 frames of a few dozen zones
+		constexpr std::size_t ring_capacity_v{ 1 << 15 };
+
+		struct Event {
+			char const* name{};
+			std::uint64_t begin{};
+			std::uint64_t end{};
+		};
+
+		// relaxed atomics so a reader racing the writer gets stale values instead of undefined behaviour,
+		// plain stores on the platforms we care about
+		struct EventSlot {
+			std::atomic<char const*> name{};
+			std::atomic<std::uint64_t> begin{};
+			std::atomic<std::uint64_t> end{};
+		};
+
+		// Written only by its thread. Readers take the count with acquire and drop any event the
+		// writer may have overwritten while it was read.
+		struct ThreadRing {
+			std::vector<EventSlot> events = std::vector<EventSlot>(ring_capacity_v);
+			std::atomic<std::uint64_t> written{};
+			std::uint32_t id{};
+			// guarded by the registry mutex
+			std::string name{};
+		};
+
+		struct Registry {
+			std::mutex mutex{};
+			// rings outlive their threads so late exports still see them
+			std::vector<std::unique_ptr<ThreadRing>> rings{};
+
+			// pairs ticks with wall time to convert between them
+			std::uint64_t origin_ticks{ read_ticks() };
+			std::chrono::steady_clock::time_point origin_time{ std::chrono::steady_clock::now() };
+
+			std::uint64_t frame_begin{ origin_ticks };
+			std::vector<ZoneSummary> summary{};
+			float frame_ms{};
+		};
+
+		[[nodiscard]] Registry& get_registry() {
+			static auto ret = Registry{};
+			return ret;
+		}
+
+		thread_local ThreadRing* t_ring{};
+
+		[[nodiscard]] ThreadRing& get_thread_ring() {
+			if (t_ring) return *t_ring;
+			auto& registry = get_registry();
+			auto const lock = std::scoped_lock{ registry.mutex };
+			auto& ring = registry.rings.emplace_back(std::make_unique<ThreadRing>());
+			ring->id = static_cast<std::uint32_t>(registry.rings.size() - 1);
+			t_ring = ring.get();
+			return *t_ring;
+		}
+
+		// measured over everything since the registry was created, so it sharpens as the program runs
+		[[nodiscard]] double get_ns_per_tick(Registry const& registry) {
+#if defined(SVE_CPU_PROFILER_TSC)
+			auto const ticks = read_ticks() - registry.origin_ticks;
+			auto const ns = std::chrono::duration<double, std::nano>{ std::chrono::steady_clock::now() - registry.origin_time }.count();
+			return ticks > 0 ? ns / static_cast<double>(ticks) : 0.0;
+#else
+			return std::chrono::duration<double, std::nano>{ std::chrono::steady_clock::duration{ 1 } }.count();
+#endif
+		}
+
+		// calls func(event) for the events still intact in ring, newest first, until it returns false
+		template <typename Func>
+		void for_each_event(ThreadRing const& ring, Func&& func) {
+			auto const written = ring.written.load(std::memory_order_acquire);
+			auto const count = std::min<std::uint64_t>(written, ring_capacity_v);
+			for (auto i = written; i > written - count; --i) {
+				auto const& slot = ring.events[(i - 1) % ring_capacity_v];
+				auto const event = Event{
+					.name = slot.name.load(std::memory_order_relaxed),
+					.begin = slot.begin.load(std::memory_order_relaxed),
+					.end = slot.end.load(std::memory_order_relaxed)
+				};
+				// pairs with the fence in record(), a slot read partly new implies the count moved on
+				std::atomic_thread_fence(std::memory_order_acquire);
+				// the writer is overwriting this slot once the count reaches it plus the capacity,
+				// the count is only bumped after the slot is complete
+				if (ring.written.load(std::memory_order_relaxed) - (i - 1) >= ring_capacity_v) return;
+				if (!func(event)) return;
+			}
+		}
+
+		[[nodiscard]] std::string escape_json(std::string_view const in) {
+			auto ret = std::string{};
+			ret.reserve(in.size());
+			for (char const c : in) {
+				if (c == '"' || c == '\\') ret.push_back('\\');
+				ret.push_back(c);
+			}
+			return ret;
+		}
+	}
+
+	void record(char const* const name, std::uint64_t const begin, std::uint64_t const end) {
+		auto& ring = get_thread_ring();
+		auto const written = ring.written.load(std::memory_order_relaxed);
+		auto& slot = ring.events[written % ring_capacity_v];
+		// keeps the slot stores after the count that marks the slot as being overwritten
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.begin.store(begin, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		ring.written.store(written + 1, std::memory_order_release);
+	}
+
+	void set_thread_name(std::string name) {
+		auto& ring = get_thread_ring();
+		auto const lock = std::scoped_lock{ get_registry().mutex };
+		ring.name = std::move(name);
+	}
+
+	void end_frame() {
+		auto& registry = get_registry();
+		auto const frame_end = read_ticks();
+		auto const ns_per_tick = get_ns_per_tick(registry);
+
+		auto const lock = std::scoped_lock{ registry.mutex };
+		registry.summary.clear();
+		for (auto const& ring : registry.rings) {
+			for_each_event(*ring, [&](Event const& event) {
+				// rings are ordered by end time
+				if (event.end < registry.frame_begin) return false;
+				if (event.end >= frame_end) return true;
+				auto const it = std::ranges::find(registry.summary, event.name, &ZoneSummary::name);
+				auto& summary = it != registry.summary.end() ? *it : registry.summary.emplace_back(ZoneSummary{ .name = event.name });
+				++summary.calls;
+				summary.ms += static_cast<float>(static_cast<double>(event.end - event.begin) * ns_per_tick / 1'000'000.0);
+				return true;
+				});
+		}
+		// zones were collected newest first
+		std::ranges::reverse(registry.summary);
+		registry.frame_ms = static_cast<float>(static_cast<double>(frame_end - registry.frame_begin) * ns_per_tick / 1'000'000.0);
+		registry.frame_begin = frame_end;
+	}
+
+	std::span<ZoneSummary const> get_frame_summary() {
+		return get_registry().summary;
+	}
+
+	float get_frame_ms() {
+		return get_registry().frame_ms;
+	}
+
+	void write_chrome_trace(std::ostream& out) {
+		auto& registry = get_registry();
+		auto const us_per_tick = get_ns_per_tick(registry) / 1'000.0;
+		auto const lock = std::scoped_lock{ registry.mutex };
+
+		out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+		auto first = true;
+		auto const separator = [&first] { return std::exchange(first, false) ? "\n" : ",\n"; };
+		for (auto const& ring : registry.rings) {
+			auto const name = ring->name.empty() ? std::format("Thread {}", ring->id) : ring->name;
+			out << std::format(R"({}{{"ph":"M","name":"thread_name","pid":0,"tid":{},"args":{{"name":"{}"}}}})", separator(), ring->id, escape_json(name));
+			for_each_event(*ring, [&](Event const& event) {
+				// zones that began before the profiler's origin can't be placed
+				if (event.begin < registry.origin_ticks) return true;
+				auto const ts = static_cast<double>(event.begin - registry.origin_ticks) * us_per_tick;
+				auto const dur = static_cast<double>(event.end - event.begin) * us_per_tick;
+				out << std::format(R"({}{{"ph":"X","name":"{}","pid":0,"tid":{},"ts":{:.3f},"dur":{:.3f}}})", separator(), escape_json(event.name), ring->id, ts, dur);
+				return true;
+				});
+		}
+		out << "\n]}\n";
+	}
+
+	bool export_chrome_trace(std::filesystem::path const& path) {
+		auto file = std::ofstream{ path };
+		if (!file.is_open()) {
+			std::println(stderr, "[sve] Failed to open '{}' for the trace", path.generic_string());
+			return false;
+		}
+		write_chrome_trace(file);
+		std::println(stderr, "[sve] Wrote CPU trace to '{}'", path.generic_string());
+		return true;
+	}
+}
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string>
+
+// 1 compiles the zones in, 0 turns SVE_PROFILE_ZONE and every function into no-ops
+#if !defined(SVE_CPU_PROFILER)
+#define SVE_CPU_PROFILER 1
+#endif
+
+#if SVE_CPU_PROFILER && (defined(_M_X64) || defined(__x86_64__))
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define SVE_CPU_PROFILER_TSC
+#endif
+
+namespace sve::cpu_profiler {
+	struct ZoneSummary {
+		// the literal passed to SVE_PROFILE_ZONE
+		char const* name{};
+		std::uint32_t calls{};
+		// inclusive, summed over every thread
+		float ms{};
+	};
+
+#if SVE_CPU_PROFILER
+	// the time stamp counter where available, it is invariant on every CPU this engine targets
+	[[nodiscard]] inline std::uint64_t read_ticks() {
+#if defined(SVE_CPU_PROFILER_TSC)
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	// appends to the calling thread's ring, lock-free once the thread has recorded its first zone
+	void record(char const* name, std::uint64_t begin, std::uint64_t end);
+
+	// use SVE_PROFILE_ZONE, name must be a string literal
+	class Zone {
+	public:
+		explicit Zone(char const* name) : m_name(name), m_begin(read_ticks()) {}
+		~Zone() { record(m_name, m_begin, read_ticks()); }
+
+		Zone(Zone const&) = delete;
+		Zone& operator=(Zone const&) = delete;
+		Zone(Zone&&) = delete;
+		Zone& operator=(Zone&&) = delete;
+
+	private:
+		char const* m_name{};
+		std::uint64_t m_begin{};
+	};
+
+	// shown as the thread's name in traces, threads without one are named by their index
+	void set_thread_name(std::string name);
+
+	// closes the frame: summarizes the zones that ended since the previous call, on every thread
+	void end_frame();
+	// zones of the last closed frame by first appearance, valid until the next end_frame()
+	[[nodiscard]] std::span<ZoneSummary const> get_frame_summary();
+	[[nodiscard]] float get_frame_ms();
+
+	// every zone still in the rings as Chrome trace_event JSON, for chrome://tracing or Perfetto
+	void write_chrome_trace(std::ostream& out);
+	// false if the file can't be written
+	bool export_chrome_trace(std::filesystem::path const& path);
+#else
+	class Zone {
+	public:
+		explicit Zone(char const* /*name*/) {}
+		~Zone() {}
+	};
+
+	inline void set_thread_name(std::string /*name*/) {}
+	inline void end_frame() {}
+	[[nodiscard]] inline std::span<ZoneSummary const> get_frame_summary() { return {}; }
+	[[nodiscard]] inline float get_frame_ms() { return 0.0f; }
+	inline void write_chrome_trace(std::ostream& /*out*/) {}
+	inline bool export_chrome_trace(std::filesystem::path const& /*path*/) { return false; }
+#endif
+}
+
+#define SVE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SVE_PROFILE_CONCAT(a, b) SVE_PROFILE_CONCAT_IMPL(a, b)
+
+// times the rest of the enclosing block on the calling thread
+#if SVE_CPU_PROFILER
+#define SVE_PROFILE_ZONE(name) ::sve::cpu_profiler::Zone const SVE_PROFILE_CONCAT(sve_profile_zone_, __LINE__){ name }
+#else
+#define SVE_PROFILE_ZONE(name) static_cast<void>(0)
+#endif
@@ -56,8 +56,8 @@ namespace sve {
 		m_device = Scoped<vk::Device, Deleter>{ create_info.device };
 	}
 
-	void DearImGui::Deleter::operator()(vk::Device const device) const {
-		device.waitIdle();
+	void DearImGui::Deleter::operator()(vk::Device const) const {
+		// the owner has waited for every frame that drew the UI
 		ImGui_ImplVulkan_Shutdown();
 		ImGui_ImplGlfw_Shutdown();
 		ImGui::DestroyContext();
@@ -0,0 +1,153 @@
+#include "defragmenter.hpp"
+#include <cassert>
+#include <print>
+#include <span>
+
+namespace sve {
+	namespace {
+		// untracked allocations are skipped rather than moved, which VMA may keep offering,
+		// so a run gives up after this many passes
+		constexpr std::uint32_t max_passes_per_run_v{ 16 };
+	}
+
+	Defragmenter::Defragmenter(CreateInfo const& create_info) : m_info(create_info) {}
+
+	Defragmenter::~Defragmenter() {
+		if (m_in_pass) {
+			m_info.timeline->wait(m_pass_value);
+			end_pass();
+		}
+		if (is_running()) end_run();
+	}
+
+	void Defragmenter::track(vma::Buffer& buffer) {
+		assert(buffer.get().allocation && !buffer.get().mapped);
+		m_tracked.insert_or_assign(buffer.get().allocation, &buffer);
+	}
+
+	void Defragmenter::untrack(vma::Buffer const& buffer) {
+		if (m_in_pass) {
+			m_info.timeline->wait(m_pass_value);
+			end_pass();
+		}
+		m_tracked.erase(buffer.get().allocation);
+	}
+
+	void Defragmenter::collect() {
+		if (m_in_pass && m_info.timeline->is_complete(m_pass_value)) end_pass();
+	}
+
+	bool Defragmenter::record(vk::CommandBuffer const command_buffer) {
+		if (m_in_pass || !m_enabled || m_tracked.empty()) return false;
+		if (!is_running()) {
+			if (m_idle_frames_left > 0) {
+				--m_idle_frames_left;
+				return false;
+			}
+			begin_run();
+			if (!is_running()) return false;
+		}
+
+		auto const result = vmaBeginDefragmentationPass(m_info.allocator, m_context, &m_pass);
+		if (result != VK_INCOMPLETE) {
+			// VK_SUCCESS: nothing left to move
+			if (result != VK_SUCCESS) std::println(stderr, "[sve] Defragmentation pass failed: {}", vk::to_string(static_cast<vk::Result>(result)));
+			end_run();
+			return false;
+		}
+		m_in_pass = true;
+		++m_run_passes;
+
+		m_copies.clear();
+		for (auto& move : std::span{ m_pass.pMoves, m_pass.moveCount }) {
+			auto const it = m_tracked.find(move.srcAllocation);
+			if (it == m_tracked.end()) {
+				move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+				continue;
+			}
+
+			auto& raw_buffer = it->second->get();
+			auto buffer_ci = vk::BufferCreateInfo{};
+			buffer_ci.setSize(raw_buffer.size)
+				.setUsage(raw_buffer.usage);
+			auto const buffer = m_info.device.createBuffer(buffer_ci);
+			if (vmaBindBufferMemory(m_info.allocator, move.dstTmpAllocation, buffer) != VK_SUCCESS) {
+				m_info.device.destroyBuffer(buffer);
+				move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+				continue;
+			}
+
+			m_copies.push_back(Copy{ .src = raw_buffer.buffer, .dst = buffer, .size = raw_buffer.size });
+			m_old_buffers.push_back(raw_buffer.buffer);
+			// the allocation handle stays, after the pass it refers to the new place
+			raw_buffer.buffer = buffer;
+			++m_moved_count;
+			m_moved_bytes += raw_buffer.size;
+		}
+
+		if (m_copies.empty()) {
+			end_pass();
+			return false;
+		}
+
+		// earlier frames and the uploads this frame waited for may have written the sources,
+		// and everything recorded after the copies reads the new buffers
+		auto barrier = vk::MemoryBarrier2{};
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite);
+		auto dependency_info = vk::DependencyInfo{};
+		dependency_info.setMemoryBarriers(barrier);
+		command_buffer.pipelineBarrier2(dependency_info);
+
+		for (auto const& copy : m_copies) {
+			auto const region = vk::BufferCopy2{ 0, 0, copy.size };
+			auto copy_info = vk::CopyBufferInfo2{};
+			copy_info.setSrcBuffer(copy.src)
+				.setDstBuffer(copy.dst)
+				.setRegions(region);
+			command_buffer.copyBuffer2(copy_info);
+		}
+
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite);
+		command_buffer.pipelineBarrier2(dependency_info);
+
+		m_pass_value = m_info.timeline->get_frame_value();
+		++m_pass_count;
+		return true;
+	}
+
+	void Defragmenter::begin_run() {
+		auto defragmentation_info = VmaDefragmentationInfo{};
+		defragmentation_info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+		defragmentation_info.maxBytesPerPass = m_info.max_bytes_per_pass;
+		defragmentation_info.maxAllocationsPerPass = m_info.max_moves_per_pass;
+		auto const result = vmaBeginDefragmentation(m_info.allocator, &defragmentation_info, &m_context);
+		if (result != VK_SUCCESS) {
+			std::println(stderr, "[sve] Failed to begin defragmentation: {}", vk::to_string(static_cast<vk::Result>(result)));
+			m_context = {};
+			m_idle_frames_left = m_info.idle_frames;
+		}
+		m_run_passes = 0;
+	}
+
+	void Defragmenter::end_run() {
+		vmaEndDefragmentation(m_info.allocator, m_context, nullptr);
+		m_context = {};
+		m_idle_frames_left = m_info.idle_frames;
+	}
+
+	void Defragmenter::end_pass() {
+		// VMA frees the old places when the pass ends, nothing may be bound to them by then
+		for (auto const buffer : m_old_buffers) m_info.device.destroyBuffer(buffer);
+		m_old_buffers.clear();
+		m_in_pass = false;
+
+		auto const result = vmaEndDefragmentationPass(m_info.allocator, m_context, &m_pass);
+		if (result == VK_SUCCESS || m_run_passes >= max_passes_per_run_v) end_run();
+	}
+}
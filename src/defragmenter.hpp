@@ -0,0 +1,87 @@
+#pragma once
+#include "vma.hpp"
+#include "frame_timeline.hpp"
+#include <vulkan/vulkan.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace sve {
+	struct DefragmenterCreateInfo {
+		vk::Device device{};
+		VmaAllocator allocator{};
+		FrameTimeline const* timeline{};
+		// bound the copies a single frame takes on
+		vk::DeviceSize max_bytes_per_pass{ 16 * 1024 * 1024 };
+		std::uint32_t max_moves_per_pass{ 32 };
+		// frames to wait after a finished run before looking for fragmentation again
+		std::uint32_t idle_frames{ 600 };
+	};
+
+	// Compacts memory with VMA's defragmentation, one bounded pass at a time so no frame stalls.
+	// A pass is recorded at the end of a frame: moved buffers are recreated in their new place,
+	// copied by that frame's command buffer and swapped in right away. The old buffers are destroyed
+	// and the pass ended once the frame completed. Only tracked buffers move, images and other
+	// allocations stay where they are.
+	class Defragmenter {
+	public:
+		using CreateInfo = DefragmenterCreateInfo;
+
+		explicit Defragmenter(CreateInfo const& create_info);
+		// waits for a running pass
+		~Defragmenter();
+
+		Defragmenter(Defragmenter const&) = delete;
+		Defragmenter& operator=(Defragmenter const&) = delete;
+		Defragmenter(Defragmenter&&) = delete;
+		Defragmenter& operator=(Defragmenter&&) = delete;
+
+		// buffer must be a device buffer that stays at this address until untrack(),
+		// its owner has to read the vk::Buffer again every time it records a use
+		void track(vma::Buffer& buffer);
+		// waits for a running pass, which may be moving the buffer
+		void untrack(vma::Buffer const& buffer);
+
+		// ends the running pass once the frame that recorded it has completed
+		void collect();
+		// starts a pass if none is running and records its copies, call outside rendering right before
+		// the frame is submitted; returns true if anything moved, transfers on other queues must then
+		// wait for this frame before writing to tracked buffers
+		[[nodiscard]] bool record(vk::CommandBuffer command_buffer);
+
+		void set_enabled(bool enabled) { m_enabled = enabled; }
+		[[nodiscard]] bool is_enabled() const { return m_enabled; }
+		[[nodiscard]] bool is_running() const { return m_context != VmaDefragmentationContext{}; }
+		[[nodiscard]] bool is_in_pass() const { return m_in_pass; }
+		[[nodiscard]] std::uint32_t get_pass_count() const { return m_pass_count; }
+		[[nodiscard]] std::uint32_t get_moved_count() const { return m_moved_count; }
+		[[nodiscard]] vk::DeviceSize get_moved_bytes() const { return m_moved_bytes; }
+
+	private:
+		struct Copy {
+			vk::Buffer src{};
+			vk::Buffer dst{};
+			vk::DeviceSize size{};
+		};
+
+		void begin_run();
+		void end_run();
+		void end_pass();
+
+		CreateInfo m_info{};
+		std::unordered_map<VmaAllocation, vma::Buffer*> m_tracked{};
+		bool m_enabled{ true };
+
+		VmaDefragmentationContext m_context{};
+		VmaDefragmentationPassMoveInfo m_pass{};
+		bool m_in_pass{};
+		std::uint64_t m_pass_value{};
+		std::uint32_t m_run_passes{};
+		std::uint32_t m_idle_frames_left{};
+		std::vector<Copy> m_copies{};
+		std::vector<vk::Buffer> m_old_buffers{};
+
+		std::uint32_t m_pass_count{};
+		std::uint32_t m_moved_count{};
+		vk::DeviceSize m_moved_bytes{};
+	};
+}
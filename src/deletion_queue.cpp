@@ -0,0 +1,15 @@
+#include "deletion_queue.hpp"
+
+namespace sve {
+	void DeletionQueue::collect(std::uint64_t const completed_value) {
+		for (auto& entry : m_entries) {
+			if (entry.retire_value <= completed_value) entry.resource.reset();
+		}
+		std::erase_if(m_entries, [](Entry const& entry) { return !entry.resource; });
+	}
+
+	void DeletionQueue::flush() {
+		for (auto& entry : m_entries) entry.resource.reset();
+		m_entries.clear();
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sve {
+	// Owns released GPU resources until the frame timeline reaches the value they were last used by.
+	// Any movable RAII handle works: vk::Unique*, vma::Buffer, vma::Image, Texture, ShaderProgram...
+	class DeletionQueue {
+	public:
+		template <typename Type>
+		void push(std::uint64_t const retire_value, Type&& resource) {
+			static_assert(!std::is_lvalue_reference_v<Type>, "resources must be moved into the queue");
+			m_entries.push_back(Entry{
+				.retire_value = retire_value,
+				.resource = std::make_unique<Holder<Type>>(std::move(resource))
+			});
+		}
+
+		// destroys entries whose value has completed, in the order they were pushed
+		void collect(std::uint64_t completed_value);
+		// destroys everything, the caller must have waited for the GPU
+		void flush();
+
+		[[nodiscard]] std::size_t size() const { return m_entries.size(); }
+		[[nodiscard]] bool empty() const { return m_entries.empty(); }
+
+	private:
+		struct Resource {
+			virtual ~Resource() = default;
+		};
+
+		template <typename Type>
+		struct Holder : Resource {
+			explicit Holder(Type&& value) : value(std::move(value)) {}
+
+			Type value;
+		};
+
+		struct Entry {
+			std::uint64_t retire_value{};
+			std::unique_ptr<Resource> resource{};
+		};
+
+		std::vector<Entry> m_entries{};
+	};
+}
@@ -1,7 +1,7 @@
 #include "descriptor_buffer.hpp"
 
 namespace sve {
-	DescriptorBuffer::DescriptorBuffer(VmaAllocator allocator, std::uint32_t const queue_family, vk::BufferUsageFlags const usage)
+	DescriptorBuffer::DescriptorBuffer(vma::RawAllocator allocator, std::uint32_t const queue_family, vk::BufferUsageFlags const usage)
 	: m_allocator(allocator), m_queue_family(queue_family), m_usage(usage) {
 		for (auto& buffer : m_buffers) {
 			write_to(buffer, {});
@@ -9,7 +9,7 @@ namespace sve {
 	class DescriptorBuffer
 	{
 	public:
-		explicit DescriptorBuffer(VmaAllocator allocator, std::uint32_t queue_family, vk::BufferUsageFlags usage);
+		explicit DescriptorBuffer(vma::RawAllocator allocator, std::uint32_t queue_family, vk::BufferUsageFlags usage);
 
 		void write_at(std::size_t frame_index, std::span<std::byte const> bytes);
 
@@ -23,7 +23,7 @@ namespace sve {
 
 		void write_to(Buffer& out, std::span<std::byte const> bytes) const;
 
-		VmaAllocator m_allocator{};
+		vma::RawAllocator m_allocator{};
 		std::uint32_t m_queue_family{};
 		vk::BufferUsageFlags m_usage{};
 		Buffered<Buffer> m_buffers{};
@@ -0,0 +1,86 @@
+#include "draw_batcher.hpp"
+#include "cpu_profiler.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace sve {
+	namespace {
+		[[nodiscard]] bool is_compatible(DrawBatch const& batch, Object const& object) {
+			return batch.shader == object.material.shader
+				&& batch.mesh == object.mesh
+				&& batch.texture == object.material.texture;
+		}
+	}
+
+	void gather_instances(std::span<GatherItem const> items, TransformSoA& transforms, std::span<std::uint32_t> colors, std::span<std::uint32_t> texture_indices) {
+		for (auto const& item : items) {
+			auto const& object = *item.object;
+			for (auto instance = item.first_instance; instance < item.first_instance + object.instance_count; ++instance) {
+				transforms.set(instance, object.transform);
+			}
+			std::fill_n(colors.begin() + item.first_instance, object.instance_count, object.color.to_rgba8());
+			std::fill_n(texture_indices.begin() + item.first_instance, object.instance_count, item.texture_index);
+		}
+	}
+
+	void DrawBatcher::build(RenderQueue const& queue, ResourceRegistry const& resources, JobSystem& jobs, std::pmr::memory_resource& scratch) {
+		clear();
+		auto const items = queue.get_items();
+		// one per queue item, lets the gather run in parallel
+		auto gather_items = std::pmr::vector<GatherItem>{ &scratch };
+		gather_items.reserve(items.size());
+
+		// merging is a serial scan, only the per-instance data is gathered in parallel
+		for (auto const& item : items) {
+			auto const& object = queue.get_object(item);
+			if (m_batches.empty() || !is_compatible(m_batches.back(), object)) {
+				m_batches.push_back(DrawBatch{
+					.shader = object.material.shader,
+					.mesh = object.mesh,
+					.texture = object.material.texture,
+					.texture_index = resources.get(object.material.texture).get_index(),
+					.first_instance = m_instance_count
+				});
+			}
+			gather_items.push_back(GatherItem{
+				.object = &object,
+				.first_instance = m_instance_count,
+				.texture_index = m_batches.back().texture_index
+			});
+			m_batches.back().instance_count += object.instance_count;
+			m_instance_count += object.instance_count;
+		}
+
+		m_transforms.resize(m_instance_count);
+		m_colors.resize(m_instance_count);
+		m_texture_indices.resize(m_instance_count);
+		jobs.parallel_for(gather_items.size(), gather_grain_v, [&](std::size_t const first, std::size_t const count) {
+			SVE_PROFILE_ZONE("Gather instances");
+			gather_instances(std::span{ gather_items }.subspan(first, count), m_transforms, m_colors, m_texture_indices);
+		});
+	}
+
+	void DrawBatcher::write_instances(std::span<glm::mat4> out, JobSystem& jobs) const {
+		assert(out.size() >= m_instance_count);
+		jobs.parallel_for(m_instance_count, evaluate_grain_v, [&](std::size_t const first, std::size_t const count) {
+			SVE_PROFILE_ZONE("Evaluate instances");
+			m_transforms.evaluate(out.subspan(first, count), first);
+		});
+	}
+
+	void DrawBatcher::write_instances(std::span<AffineInstance> out, JobSystem& jobs) const {
+		assert(out.size() >= m_instance_count);
+		jobs.parallel_for(m_instance_count, evaluate_grain_v, [&](std::size_t const first, std::size_t const count) {
+			SVE_PROFILE_ZONE("Evaluate instances");
+			m_transforms.evaluate(out.subspan(first, count), m_colors, m_texture_indices, first);
+		});
+	}
+
+	void DrawBatcher::clear() {
+		m_transforms.clear();
+		m_colors.clear();
+		m_texture_indices.clear();
+		m_batches.clear();
+		m_instance_count = 0;
+	}
+}
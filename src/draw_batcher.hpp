@@ -0,0 +1,57 @@
+#pragma once
+#include "utils/object.hpp"
+#include "render_queue.hpp"
+#include "resource_registry.hpp"
+#include "job_system.hpp"
+#include "utils/transform_soa.hpp"
+#include <glm/mat4x4.hpp>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace sve {
+	// a run of instances that share shader, mesh and texture, drawn with a single drawIndexed
+	struct DrawBatch {
+		ShaderHandle shader{};
+		MeshHandle mesh{};
+		TextureHandle texture{};
+		std::uint32_t texture_index{};
+		std::uint32_t first_instance{};
+		std::uint32_t instance_count{};
+	};
+
+	// a queue item with everything the gather needs, resolved by the serial merge
+	struct GatherItem {
+		Object const* object{};
+		std::uint32_t first_instance{};
+		std::uint32_t texture_index{};
+	};
+
+	// the parallel step of DrawBatcher::build: writes the transform, color and texture index of
+	// every instance of items, the outputs must cover all of them
+	void gather_instances(std::span<GatherItem const> items, TransformSoA& transforms, std::span<std::uint32_t> colors, std::span<std::uint32_t> texture_indices);
+
+	class DrawBatcher {
+	public:
+		// items per job when gathering and evaluating instances
+		static constexpr std::size_t gather_grain_v{ 4096 };
+		static constexpr std::size_t evaluate_grain_v{ 16384 };
+
+		// merges adjacent compatible items, expects the queue to be sorted already.
+		// scratch only holds temporaries of the call
+		void build(RenderQueue const& queue, ResourceRegistry const& resources, JobSystem& jobs, std::pmr::memory_resource& scratch);
+		void write_instances(std::span<glm::mat4> out, JobSystem& jobs) const;
+		void write_instances(std::span<AffineInstance> out, JobSystem& jobs) const;
+		void clear();
+
+		[[nodiscard]] std::span<DrawBatch const> get_batches() const { return m_batches; }
+		[[nodiscard]] std::uint32_t get_instance_count() const { return m_instance_count; }
+
+	private:
+		TransformSoA m_transforms{};
+		std::vector<std::uint32_t> m_colors{};
+		std::vector<std::uint32_t> m_texture_indices{};
+		std::vector<DrawBatch> m_batches{};
+		std::uint32_t m_instance_count{};
+	};
+}
@@ -1,6 +1,8 @@
 #include "engine.hpp"
+#include "cpu_profiler.hpp"
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <bit>
 #include <cassert>
 #include <chrono>
@@ -17,11 +19,6 @@ using namespace std::chrono_literals;
 
 namespace sve {
 	namespace {
-		template <typename T>
-		[[nodiscard]] constexpr auto to_byte_array(T const& t) {
-			return std::bit_cast<std::array<std::byte, sizeof(T)>>(t);
-		}
-
 		constexpr auto layout_binding(std::uint32_t binding, vk::DescriptorType const type) {
 			return vk::DescriptorSetLayoutBinding{ binding, type, 1, vk::ShaderStageFlagBits::eAllGraphics };
 		}
@@ -33,7 +30,7 @@ namespace sve {
 				auto ret = path / dir_name_v;
 				if (fs::is_directory(ret)) return ret;
 			}
-			std::println("[sve] Warning: Could not locate '{}' directory", dir_name_v);
+			std::println(stderr, "[sve] Warning: Could not locate '{}' directory", dir_name_v);
 			return fs::current_path();
 		}
 
@@ -47,7 +44,7 @@ namespace sve {
 						return properties.layerName == layer;
 					};
 				if (std::ranges::find_if(available, pred) == available.end()) {
-					std::println("[sve] [WARNING] Vulkan Layer '{}' not found", layer);
+					std::println(stderr, "[sve] [WARNING] Vulkan Layer '{}' not found", layer);
 					continue;
 				}
 				ret.push_back(layer);
@@ -78,23 +75,28 @@ namespace sve {
 	}
 
 	void Engine::run() {
+		init();
+		create_shader();
+		create_shader_resources();
+
+		if (m_ci.headless) headless_loop();
+		else main_loop();
+	}
+
+	void Engine::init() {
 		m_assets_dir = locate_assets_dir();
 
-		create_window();
+		cpu_profiler::set_thread_name("Main");
+		m_jobs.emplace();
+		if (!m_ci.headless) create_window();
 		create_instance();
-		create_surface();
+		if (!m_ci.headless) create_surface();
 		select_gpu();
 		create_device();
 		create_allocator();
-		create_swapchain();
+		if (!m_ci.headless) create_swapchain();
 
 		create_renderer();
-		create_shader();
-
-		create_shader_resources();
-
-
-		main_loop();
 	}
 
 	void Engine::create_window() {
@@ -112,7 +114,8 @@ namespace sve {
 		app_info.setPApplicationName("Stan's Vulkan Engine").setApiVersion(vk_version_v);
 
 		auto instance_ci = vk::InstanceCreateInfo{};
-		auto const extensions = glfw::instance_extensions();
+		// headless rendering needs no surface extensions, and no GLFW
+		auto const extensions = m_ci.headless ? std::span<char const* const>{} : glfw::instance_extensions();
 		instance_ci.setPApplicationInfo(&app_info).setPEnabledExtensionNames(extensions);
 
 		static constexpr auto layers_v = std::array{
@@ -131,14 +134,17 @@ namespace sve {
 
 	void Engine::select_gpu() {
 		m_gpu = get_suitable_gpu(*m_instance, *m_surface);
-		std::println("Using GPU: {}", std::string_view{ m_gpu.properties.deviceName });
+		std::println(stderr, "[sve] Using GPU: {}", std::string_view{ m_gpu.properties.deviceName });
 	}
 
 	void Engine::create_device() {
-		auto queue_ci = vk::DeviceQueueCreateInfo{};
+		auto queue_cis = std::vector<vk::DeviceQueueCreateInfo>(1);
 
 		static constexpr auto queue_priorities_v = std::array{ 1.0f };
-		queue_ci.setQueueFamilyIndex(m_gpu.queue_family).setQueueCount(1).setQueuePriorities(queue_priorities_v);
+		queue_cis[0].setQueueFamilyIndex(m_gpu.queue_family).setQueueCount(1).setQueuePriorities(queue_priorities_v);
+		if (m_gpu.transfer_queue_family != m_gpu.queue_family) {
+			queue_cis.emplace_back().setQueueFamilyIndex(m_gpu.transfer_queue_family).setQueueCount(1).setQueuePriorities(queue_priorities_v);
+		}
 
 		auto enabled_features = vk::PhysicalDeviceFeatures{};
 		enabled_features.fillModeNonSolid = m_gpu.features.fillModeNonSolid;
@@ -151,30 +157,80 @@ namespace sve {
 		sync_feature.setPNext(&dynamic_rendering_feature);
 		auto shader_object_feature = vk::PhysicalDeviceShaderObjectFeaturesEXT{ vk::True };
 		dynamic_rendering_feature.setPNext(&shader_object_feature);
+		auto const device_extensions = m_gpu.device.enumerateDeviceExtensionProperties();
+		auto const has_extension = [&device_extensions](std::string_view const name) {
+			return std::ranges::any_of(device_extensions, [name](vk::ExtensionProperties const& properties) {
+				return properties.extensionName.data() == name;
+				});
+			};
+		auto supported_vulkan12_features = vk::PhysicalDeviceVulkan12Features{};
+		auto supported_present_id_features = vk::PhysicalDevicePresentIdFeaturesKHR{};
+		auto supported_present_wait_features = vk::PhysicalDevicePresentWaitFeaturesKHR{};
+		if (!m_ci.headless && has_extension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && has_extension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+			supported_vulkan12_features.setPNext(&supported_present_id_features);
+			supported_present_id_features.setPNext(&supported_present_wait_features);
+		}
+		auto supported_features = vk::PhysicalDeviceFeatures2{};
+		supported_features.setPNext(&supported_vulkan12_features);
+		m_gpu.device.getFeatures2(&supported_features);
+		m_draw_indirect_count = supported_vulkan12_features.drawIndirectCount == vk::True;
+		m_present_wait = supported_present_id_features.presentId == vk::True && supported_present_wait_features.presentWait == vk::True;
+
+		// get_suitable_gpu() only picks devices with the timeline semaphore and descriptor indexing features
+		auto vulkan12_features = vk::PhysicalDeviceVulkan12Features{};
+		vulkan12_features.setDrawIndirectCount(supported_vulkan12_features.drawIndirectCount)
+			.setTimelineSemaphore(vk::True)
+			.setRuntimeDescriptorArray(vk::True)
+			.setDescriptorBindingPartiallyBound(vk::True)
+			.setDescriptorBindingSampledImageUpdateAfterBind(vk::True)
+			.setDescriptorBindingUpdateUnusedWhilePending(vk::True)
+			.setShaderSampledImageArrayNonUniformIndexing(vk::True);
+		shader_object_feature.setPNext(&vulkan12_features);
+
+		// present wait is optional, it lets the low latency mode block on the previous present
+		auto present_id_feature = vk::PhysicalDevicePresentIdFeaturesKHR{ vk::True };
+		auto present_wait_feature = vk::PhysicalDevicePresentWaitFeaturesKHR{ vk::True };
+		present_id_feature.setPNext(&present_wait_feature);
+		auto extensions = std::vector<char const*>{ "VK_EXT_shader_object" };
+		if (!m_ci.headless) extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		if (m_present_wait) {
+			vulkan12_features.setPNext(&present_id_feature);
+			extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		}
+		// real budgets let allocations stay within what the OS grants this process
+		m_memory_budget = has_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (m_memory_budget) extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
 		auto device_ci = vk::DeviceCreateInfo{};
-		static constexpr auto extensions_v = std::array{ VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_EXT_shader_object" };
-		device_ci.setPEnabledExtensionNames(extensions_v).setQueueCreateInfos(queue_ci).setPEnabledFeatures(&enabled_features).setPNext(&sync_feature);
+		device_ci.setPEnabledExtensionNames(extensions).setQueueCreateInfos(queue_cis).setPEnabledFeatures(&enabled_features).setPNext(&sync_feature);
 
 		m_device = m_gpu.device.createDeviceUnique(device_ci);
 		VULKAN_HPP_DEFAULT_DISPATCHER.init(*m_device);
 
 		static constexpr std::uint32_t queue_index_v{ 0 };
 		m_queue = m_device->getQueue(m_gpu.queue_family, queue_index_v);
+		if (m_gpu.transfer_queue_family != m_gpu.queue_family) {
+			m_transfer_queue = m_device->getQueue(m_gpu.transfer_queue_family, queue_index_v);
+		}
 
 		m_waiter = *m_device;
 	}
 
 	void Engine::create_allocator() {
-		m_allocator = vma::create_allocator(*m_instance, m_gpu.device, *m_device);
+		m_allocator = vma::create_allocator(*m_instance, m_gpu.device, *m_device, m_memory_budget);
 	}
 
 	void Engine::create_swapchain() {
 		auto const size = glfw::framebuffer_size(m_window.get());
-		m_swapchain.emplace(*m_device, m_gpu, *m_surface, size);
+		m_swapchain.emplace(*m_device, m_gpu, *m_surface, size, m_present_wait);
 	}
 
 	void Engine::create_shader() {
+		m_shader = create_shader_program();
+	}
+
+	ShaderHandle Engine::create_shader_program(std::uint8_t const flags) {
 		auto const vertex_spirv = to_spir_v(asset_path("shader.vert"));
 		auto const fragment_spirv = to_spir_v(asset_path("shader.frag"));
 
@@ -188,9 +244,25 @@ namespace sve {
 			.vertex_spirv = vertex_spirv,
 			.fragment_spirv = fragment_spirv,
 			.vertex_input = vertex_input_v,
-			.set_layouts = m_renderer->m_set_layout_views
+			.set_layouts = m_renderer->m_set_layout_views,
+			.push_constant_ranges = Renderer::push_constant_ranges_v
+		};
+		auto shader = ShaderProgram{ shader_ci };
+		shader.flags = flags;
+		return m_renderer->get_resources().add(std::move(shader));
+	}
+
+	TextureHandle Engine::create_texture(Bitmap const& bitmap, vk::Sampler const shared_sampler) {
+		auto const texture_ci = Texture::CreateInfo{
+			.device = *m_device,
+			.allocator = m_allocator.get(),
+			.queue_family = m_gpu.queue_family,
+			.uploads = m_renderer->get_upload_queue(),
+			.bitmap = bitmap,
+			.registry = m_renderer->get_texture_registry(),
+			.shared_sampler = shared_sampler
 		};
-		m_shader.emplace(shader_ci);
+		return m_renderer->get_resources().add(Texture{ texture_ci });
 	}
 
 	void Engine::create_shader_resources() {
@@ -204,23 +276,6 @@ namespace sve {
 
 		static constexpr auto indices_v = std::array{ 0u, 1u, 2u, 2u, 3u, 0u };
 
-		static auto constexpr vertices_bytes_v = to_byte_array(vertices_v);
-		static auto constexpr indices_bytes_v = to_byte_array(indices_v);
-
-		static auto constexpr total_bytes_v = std::array<std::span<std::byte const>, 2>{ vertices_bytes_v, indices_bytes_v };
-
-		auto buffer_ci = vma::BufferCreateInfo{
-			.allocator = m_allocator.get(),
-			.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer,
-			.queue_family = m_gpu.queue_family
-		};
-		
-
-		m_vbo = vma::create_device_buffer(buffer_ci, create_command_block(), total_bytes_v);
-		
-		//m_view_ubo.emplace(m_allocator.get(), m_gpu.queue_family, vk::BufferUsageFlagBits::eUniformBuffer);
-		m_instance_ssbo.emplace(m_allocator.get(), m_gpu.queue_family, vk::BufferUsageFlagBits::eStorageBuffer);
-
 		using Pixel = std::array<std::byte, 4>;
 		static constexpr auto rgby_pixels_v = std::array{
 			Pixel{ std::byte{0xff}, {}, {}, std::byte{0xff} },
@@ -235,32 +290,47 @@ namespace sve {
 			.size = {2, 2}
 		};
 
-		auto texture_ci = Texture::CreateInfo{
-			.device = *m_device,
-			.allocator = m_allocator.get(),
-			.queue_family = m_gpu.queue_family,
-			.command_block = create_command_block(),
-			.bitmap = rgby_bitmap_v
-		};
+		// pixel art textures share one registered sampler instead of creating their own
+		m_nearest_sampler = m_renderer->create_sampler(vk::SamplerCreateInfo{ sampler_ci_v }.setMagFilter(vk::Filter::eNearest));
+		m_texture = create_texture(rgby_bitmap_v, *m_renderer->get_resources().get(m_nearest_sampler));
 
-		texture_ci.sampler.setMagFilter(vk::Filter::eNearest);
-		m_texture.emplace(std::move(texture_ci));
+		m_quad = m_renderer->create_mesh(vertices_v, indices_v);
 
-		m_object.mesh.vertex_buffer = vma::create_device_buffer(buffer_ci, create_command_block(), total_bytes_v);
-		m_object.mesh.index_count = 6;
-		m_object.material.texture = &m_texture.value();
-		m_object.material.shader = &m_shader.value();
+		m_object.mesh = m_quad;
+		m_object.material.texture = m_texture;
+		m_object.material.shader = m_shader;
+		m_renderer->add(m_object);
 	}
 
 	void Engine::create_renderer() {
-		auto renderer_ci = RendererCreateInfo{ .swapchain = *m_swapchain };
+		auto renderer_ci = RendererCreateInfo{};
 		renderer_ci.device = *m_device;
-		renderer_ci.format = m_swapchain->get_format();
+		if (m_swapchain) {
+			renderer_ci.swapchain = &*m_swapchain;
+			renderer_ci.format = m_swapchain->get_format();
+		}
+		renderer_ci.headless_size = m_ci.headless_size;
 		renderer_ci.gpu = m_gpu;
 		renderer_ci.instance = *m_instance;
 		renderer_ci.queue = m_queue;
-		renderer_ci.window = &*m_window;
+		renderer_ci.transfer_queue = m_transfer_queue;
+		renderer_ci.window = m_window.get();
 		renderer_ci.allocator = &m_allocator.get();
+		renderer_ci.jobs = &*m_jobs;
+
+		// GPU culling is optional, it needs drawIndirectCount and the compiled cull shader
+		auto cull_spirv = std::vector<std::uint32_t>{};
+		auto const cull_path = asset_path("cull.comp");
+		if (!m_draw_indirect_count) {
+			std::println(stderr, "[sve] GPU culling disabled: drawIndirectCount not supported");
+		}
+		else if (!fs::exists(cull_path)) {
+			std::println(stderr, "[sve] GPU culling disabled: '{}' not found", cull_path.generic_string());
+		}
+		else {
+			cull_spirv = to_spir_v(cull_path);
+		}
+		renderer_ci.cull_spirv = cull_spirv;
 
 		m_renderer.emplace(renderer_ci);
 	}
@@ -269,36 +339,33 @@ namespace sve {
 		return m_assets_dir / uri;
 	}
 
-	CommandBlock Engine::create_command_block() const {
-		return CommandBlock{ *m_device, m_queue, *m_renderer->m_cmd_block_pool };
-	}
-
 	void Engine::main_loop() {
 		
 
 		while (glfwWindowShouldClose(m_window.get()) == GLFW_FALSE) {
-			glfwPollEvents();
-			
-			// currently does nothing, since inst
-			update_instances();
-
-			m_renderer->submit(m_object);
+			// sample input as late as possible, after waiting for a free frame
+			m_renderer->pace_frame();
+			{
+				SVE_PROFILE_ZONE("Poll events");
+				glfwPollEvents();
+			}
 
 			m_renderer->draw(Color(10, 10, 10));
 			 
 		}
 	}
 
-	void Engine::update_instances() {
-		auto instance_data = std::vector<glm::mat4>{};
+	void Engine::headless_loop() {
+		auto const start = std::chrono::steady_clock::now();
+		for (auto frame = std::uint64_t{}; frame < m_ci.headless_frames; ++frame) {
+			m_renderer->pace_frame();
+			m_renderer->draw(Color(10, 10, 10));
+		}
+		m_renderer->get_frame_timeline().wait_idle();
 
-		instance_data.reserve(1);
-		
-		instance_data.push_back(m_object.transform.model_matrix());
-		
-		auto const span = std::span{ instance_data };
-		void* data = span.data();
-		auto const bytes = std::span{ static_cast<std::byte const*>(data), span.size_bytes() };
-		m_instance_ssbo->write_at(m_frame_index, bytes);
+		auto const elapsed = std::chrono::duration<double>{ std::chrono::steady_clock::now() - start };
+		auto const& stats = m_renderer->get_stats();
+		std::println("[sve] Headless: {} frames in {:.3f} s, {:.1f} FPS ({} objects, {} batches)", m_ci.headless_frames,
+			elapsed.count(), static_cast<double>(m_ci.headless_frames) / elapsed.count(), stats.objects, stats.batches);
 	}
 }
\ No newline at end of file
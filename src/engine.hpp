@@ -13,6 +13,7 @@
 #include "texture.hpp"
 #include "utils/transform.hpp"
 #include "renderer.hpp"
+#include "job_system.hpp"
 #include "utils/object.hpp"
 #include <imgui.h>
 #include <vulkan/vulkan.hpp>
@@ -22,9 +23,31 @@
 namespace sve {
 	namespace fs = std::filesystem;
 
+	struct EngineCreateInfo {
+		// renders offscreen without a window or surface, eg on servers or with lavapipe
+		bool headless{};
+		glm::ivec2 headless_size{ 1280, 720 };
+		// frames drawn before a headless run() returns
+		std::uint64_t headless_frames{ 1000 };
+	};
+
 	class Engine {
 	public:
+		using CreateInfo = EngineCreateInfo;
+
+		explicit Engine(CreateInfo const& create_info = {}) : m_ci(create_info) {}
+
+		// init(), then draws the demo scene until the window closes or the headless frames are done
 		void run();
+		// creates the device and renderer without any content, for callers driving the renderer themselves
+		void init();
+
+		[[nodiscard]] Renderer& get_renderer() { return *m_renderer; }
+		[[nodiscard]] Gpu const& get_gpu() const { return m_gpu; }
+		// from the shader.vert and shader.frag assets
+		[[nodiscard]] ShaderHandle create_shader_program(std::uint8_t flags = ShaderProgram::flags_v);
+		// uploaded through the renderer's upload queue, shared_sampler replaces a linear one per texture
+		[[nodiscard]] TextureHandle create_texture(Bitmap const& bitmap, vk::Sampler shared_sampler = {});
 	private:
 		struct RenderSync {
 			vk::UniqueSemaphore draw{};
@@ -32,17 +55,25 @@ namespace sve {
 			vk::CommandBuffer command_buffer{};
 		};
 
+		CreateInfo m_ci{};
+
+		// the thread calling run() becomes worker 0
+		std::optional<JobSystem> m_jobs{};
 		glfw::Window m_window{};
 		vk::UniqueInstance m_instance{};
 		vk::UniqueSurfaceKHR m_surface{};
 		Gpu m_gpu{};
 		vk::UniqueDevice m_device{};
 		vk::Queue m_queue{};
+		// null without a dedicated transfer family
+		vk::Queue m_transfer_queue{};
+		bool m_draw_indirect_count{};
+		bool m_present_wait{};
+		bool m_memory_budget{};
 
 		vma::Allocator m_allocator{};
 
 		std::optional<Swapchain> m_swapchain{};
-		vk::UniqueCommandPool m_cmd_block_pool{};
 		vk::UniqueCommandPool m_render_cmd_pool{};
 		Buffered<RenderSync> m_render_sync{};
 		std::size_t m_frame_index{};
@@ -52,23 +83,22 @@ namespace sve {
 
 		fs::path m_assets_dir{};
 
-		std::optional<ShaderProgram> m_shader{};
+		ShaderHandle m_shader{};
 		bool m_wireframe{};
 
 		std::optional<Renderer> m_renderer{};
-		vma::Buffer m_vbo{};
-		std::optional<Texture> m_texture{};
-		std::optional<DescriptorBuffer> m_instance_ssbo{};
+		SamplerHandle m_nearest_sampler{};
+		TextureHandle m_texture{};
 
 		Transform m_view_transform{};
 		std::array<Transform, 2> m_instances{};
 
+		MeshHandle m_quad{};
 		Object m_object;
 
 		ScopedWaiter m_waiter{};
 
 		[[nodiscard]] fs::path asset_path(std::string_view uri) const;
-		[[nodiscard]] CommandBlock create_command_block() const;
 
 
 
@@ -83,7 +113,6 @@ namespace sve {
 		void create_shader_resources();
 		void create_renderer();
 		void main_loop();
-
-		void update_instances();
+		void headless_loop();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "frame_arena.hpp"
+#include <algorithm>
+#include <bit>
+#include <memory>
+
+namespace sve {
+	namespace {
+		// upstream blocks are aligned for anything a container element could need
+		constexpr std::size_t block_alignment_v{ alignof(std::max_align_t) };
+	}
+
+	FrameArena::FrameArena(CreateInfo const& create_info) : m_upstream(create_info.upstream) {
+		// room for the blocks of a frame that outgrows the arena a few times over
+		m_blocks.reserve(8);
+		push_block(std::max(create_info.initial_size, block_alignment_v));
+	}
+
+	FrameArena::~FrameArena() {
+		release_blocks();
+	}
+
+	void FrameArena::reset() {
+		m_peak = std::max(m_peak, m_used);
+		if (m_blocks.size() > 1) {
+			// last frame didn't fit, replace the chain with a single block that would have held it
+			auto const size = std::max(std::bit_ceil(m_peak), m_blocks.front().size);
+			release_blocks();
+			push_block(size);
+		}
+		m_offset = 0;
+		m_used = 0;
+	}
+
+	void* FrameArena::do_allocate(std::size_t const bytes, std::size_t const alignment) {
+		auto const& block = m_blocks.back();
+		auto space = block.size - m_offset;
+		void* ptr = block.data + m_offset;
+		if (!std::align(alignment, bytes, ptr, space)) {
+			// padding for over-aligned requests is paid for in the new block
+			push_block(std::max(std::bit_ceil(bytes + alignment), block.size * 2));
+			return do_allocate(bytes, alignment);
+		}
+
+		auto const end = static_cast<std::size_t>(static_cast<std::byte*>(ptr) - m_blocks.back().data) + bytes;
+		m_used += end - m_offset;
+		m_offset = end;
+		return ptr;
+	}
+
+	void FrameArena::push_block(std::size_t const size) {
+		auto const data = static_cast<std::byte*>(m_upstream->allocate(size, block_alignment_v));
+		m_blocks.push_back(Block{ .data = data, .size = size });
+		m_offset = 0;
+		m_capacity += size;
+		++m_upstream_allocations;
+	}
+
+	void FrameArena::release_blocks() {
+		for (auto const& block : m_blocks) m_upstream->deallocate(block.data, block.size, block_alignment_v);
+		m_blocks.clear();
+		m_capacity = 0;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace sve {
+	struct FrameArenaCreateInfo {
+		// grows to the largest frame seen, so this only bounds the first frames
+		std::size_t initial_size{ 256 * 1024 };
+		std::pmr::memory_resource* upstream{ std::pmr::new_delete_resource() };
+	};
+
+	// Linear allocator for CPU temporaries that live at most until the next reset(), which the
+	// renderer calls at the start of every frame. Deallocation is a no-op. A frame that outgrows the
+	// current block chains more blocks from upstream, and the next reset() replaces them with one
+	// block big enough for that frame, so steady state frames never reach the upstream resource.
+	// Not thread safe, allocate from the render thread only.
+	class FrameArena : public std::pmr::memory_resource {
+	public:
+		using CreateInfo = FrameArenaCreateInfo;
+
+		explicit FrameArena(CreateInfo const& create_info = {});
+		~FrameArena() override;
+
+		FrameArena(FrameArena const&) = delete;
+		FrameArena& operator=(FrameArena const&) = delete;
+		FrameArena(FrameArena&&) = delete;
+		FrameArena& operator=(FrameArena&&) = delete;
+
+		// invalidates everything allocated since the previous reset
+		void reset();
+
+		// bytes handed out since the last reset, including alignment padding
+		[[nodiscard]] std::size_t get_used() const { return m_used; }
+		[[nodiscard]] std::size_t get_capacity() const { return m_capacity; }
+		[[nodiscard]] std::size_t get_peak() const { return m_peak; }
+		// blocks requested from upstream since construction, stops increasing once the arena has warmed up
+		[[nodiscard]] std::uint64_t get_upstream_allocations() const { return m_upstream_allocations; }
+
+	private:
+		struct Block {
+			std::byte* data{};
+			std::size_t size{};
+		};
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void* /*ptr*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override {}
+		[[nodiscard]] bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+		void push_block(std::size_t size);
+		void release_blocks();
+
+		std::pmr::memory_resource* m_upstream{};
+		// the last block is the one being bumped
+		std::vector<Block> m_blocks{};
+		std::size_t m_offset{};
+		std::size_t m_used{};
+		std::size_t m_capacity{};
+		std::size_t m_peak{};
+		std::uint64_t m_upstream_allocations{};
+	};
+}
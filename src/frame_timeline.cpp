@@ -0,0 +1,57 @@
+#include "frame_timeline.hpp"
+#include <algorithm>
+
+namespace sve {
+	FrameTimeline::FrameTimeline(CreateInfo const& create_info) : m_device(create_info.device) {
+		auto semaphore_type_ci = vk::SemaphoreTypeCreateInfo{};
+		semaphore_type_ci.setSemaphoreType(vk::SemaphoreType::eTimeline)
+			.setInitialValue(0);
+		auto semaphore_ci = vk::SemaphoreCreateInfo{};
+		semaphore_ci.setPNext(&semaphore_type_ci);
+		m_semaphore = m_device.createSemaphoreUnique(semaphore_ci);
+
+		set_frames_in_flight(create_info.frames_in_flight);
+	}
+
+	std::size_t FrameTimeline::begin_frame() {
+		if (!m_recording) {
+			m_frame_index = m_next_slot;
+			m_recording = true;
+		}
+		wait(m_slot_values.at(m_frame_index));
+		return m_frame_index;
+	}
+
+	void FrameTimeline::end_frame() {
+		m_submitted_value = get_frame_value();
+		m_slot_values.at(m_frame_index) = m_submitted_value;
+		m_next_slot = (m_frame_index + 1) % m_frames_in_flight;
+		m_recording = false;
+	}
+
+	vk::SemaphoreSubmitInfo FrameTimeline::get_signal_info(vk::PipelineStageFlags2 const stages) const {
+		auto ret = vk::SemaphoreSubmitInfo{};
+		ret.setSemaphore(*m_semaphore)
+			.setValue(get_frame_value())
+			.setStageMask(stages);
+		return ret;
+	}
+
+	bool FrameTimeline::wait(std::uint64_t const value, std::chrono::nanoseconds const timeout) const {
+		if (value == 0) return true;
+		auto wait_info = vk::SemaphoreWaitInfo{};
+		wait_info.setSemaphores(*m_semaphore)
+			.setValues(value);
+		return m_device.waitSemaphores(wait_info, static_cast<std::uint64_t>(timeout.count())) == vk::Result::eSuccess;
+	}
+
+	std::uint64_t FrameTimeline::get_completed_value() const {
+		return m_device.getSemaphoreCounterValue(*m_semaphore);
+	}
+
+	void FrameTimeline::set_frames_in_flight(std::uint32_t const count) {
+		m_frames_in_flight = std::clamp(count, 1u, static_cast<std::uint32_t>(resource_buffering_v));
+		// slots past the new count are left alone, their last frames still retire in order
+		if (!m_recording) m_next_slot %= m_frames_in_flight;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "resource_buffering.hpp"
+#include <vulkan/vulkan.hpp>
+#include <chrono>
+#include <cstdint>
+
+namespace sve {
+	struct FrameTimelineCreateInfo {
+		vk::Device device{};
+		// clamped to [1, resource_buffering_v]
+		std::uint32_t frames_in_flight{ static_cast<std::uint32_t>(default_frames_in_flight_v) };
+	};
+
+	// Paces frames with a single timeline semaphore: the n-th submitted frame signals value n.
+	// Frame slots are handed out round robin and a slot is reused only once the value last
+	// submitted from it has completed, so the slot count can change between any two frames.
+	class FrameTimeline {
+	public:
+		using CreateInfo = FrameTimelineCreateInfo;
+
+		explicit FrameTimeline(CreateInfo const& create_info);
+
+		// blocks until the GPU is done with the next slot and returns its index,
+		// calling it again without end_frame() (eg a skipped frame) returns the same slot
+		[[nodiscard]] std::size_t begin_frame();
+		// marks the frame's value as submitted, the submission must signal get_signal_info()
+		void end_frame();
+
+		[[nodiscard]] vk::SemaphoreSubmitInfo get_signal_info(
+			vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eAllCommands
+		) const;
+
+		// false if the timeout expired first
+		bool wait(std::uint64_t value, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) const;
+		// waits for every submitted frame
+		void wait_idle() const { wait(m_submitted_value); }
+		[[nodiscard]] bool is_complete(std::uint64_t const value) const { return get_completed_value() >= value; }
+		[[nodiscard]] std::uint64_t get_completed_value() const;
+
+		// value the frame being recorded will signal
+		[[nodiscard]] std::uint64_t get_frame_value() const { return m_submitted_value + 1; }
+		[[nodiscard]] std::uint64_t get_submitted_value() const { return m_submitted_value; }
+		[[nodiscard]] std::size_t get_frame_index() const { return m_frame_index; }
+		[[nodiscard]] vk::Semaphore get_semaphore() const { return *m_semaphore; }
+
+		// takes effect from the next begin_frame()
+		void set_frames_in_flight(std::uint32_t count);
+		[[nodiscard]] std::uint32_t get_frames_in_flight() const { return m_frames_in_flight; }
+
+	private:
+		vk::Device m_device{};
+		vk::UniqueSemaphore m_semaphore{};
+		std::uint32_t m_frames_in_flight{};
+
+		// value last submitted from each slot
+		Buffered<std::uint64_t> m_slot_values{};
+		std::uint64_t m_submitted_value{};
+		std::size_t m_frame_index{};
+		std::size_t m_next_slot{};
+		bool m_recording{};
+	};
+}
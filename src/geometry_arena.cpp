@@ -0,0 +1,92 @@
+#include "geometry_arena.hpp"
+#include <glm/common.hpp>
+#include <stdexcept>
+
+namespace sve {
+	namespace {
+		[[nodiscard]] vma::Buffer create_arena_buffer(GeometryArenaCreateInfo const& create_info, vk::BufferUsageFlags const usage, vk::DeviceSize const size) {
+			auto const buffer_ci = vma::BufferCreateInfo{
+				.allocator = create_info.allocator,
+				.usage = usage,
+				.queue_family = create_info.queue_family
+			};
+			auto ret = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, size);
+			if (!ret.get().buffer) {
+				throw std::runtime_error{ "Failed to create geometry arena buffer" };
+			}
+			return ret;
+		}
+	}
+
+	GeometryArena::GeometryArena(CreateInfo const& create_info)
+	: m_uploads(create_info.uploads), m_defragmenter(create_info.defragmenter),
+	m_vertex_ranges(create_info.vertex_capacity), m_index_ranges(create_info.index_capacity) {
+		m_vertices = create_arena_buffer(create_info, vk::BufferUsageFlagBits::eVertexBuffer, create_info.vertex_capacity * sizeof(Vertex));
+		m_indices = create_arena_buffer(create_info, vk::BufferUsageFlagBits::eIndexBuffer, create_info.index_capacity * sizeof(std::uint32_t));
+		// uploads and bind() look the buffers up on every use, so they may be moved
+		if (m_defragmenter) {
+			m_defragmenter->track(m_vertices);
+			m_defragmenter->track(m_indices);
+		}
+	}
+
+	GeometryArena::~GeometryArena() {
+		if (m_defragmenter) {
+			m_defragmenter->untrack(m_vertices);
+			m_defragmenter->untrack(m_indices);
+		}
+	}
+
+	Mesh GeometryArena::create_mesh(std::span<Vertex const> const vertices, std::span<std::uint32_t const> const indices) {
+		if (vertices.empty() || indices.empty()) {
+			throw std::runtime_error{ "Mesh has no vertices or indices" };
+		}
+
+		auto const vertex_count = static_cast<std::uint32_t>(vertices.size());
+		auto const index_count = static_cast<std::uint32_t>(indices.size());
+		auto const first_vertex = m_vertex_ranges.allocate(vertex_count);
+		auto const first_index = m_index_ranges.allocate(index_count);
+		if (first_vertex == RangeAllocator::invalid_offset_v || first_index == RangeAllocator::invalid_offset_v) {
+			if (first_vertex != RangeAllocator::invalid_offset_v) m_vertex_ranges.free(first_vertex, vertex_count);
+			if (first_index != RangeAllocator::invalid_offset_v) m_index_ranges.free(first_index, index_count);
+			throw std::runtime_error{ "Geometry arena is full" };
+		}
+
+		auto const vertex_bytes = std::array{ std::as_bytes(vertices) };
+		auto const index_bytes = std::array{ std::as_bytes(indices) };
+		std::ignore = m_uploads->write_buffer(m_vertices.get().buffer, vertex_bytes, first_vertex * sizeof(Vertex));
+		std::ignore = m_uploads->write_buffer(m_indices.get().buffer, index_bytes, first_index * sizeof(std::uint32_t));
+
+		auto bounds = Rect{ .min = vertices.front().position, .max = vertices.front().position };
+		for (auto const& vertex : vertices) {
+			bounds.min = glm::min(bounds.min, vertex.position);
+			bounds.max = glm::max(bounds.max, vertex.position);
+		}
+
+		return Mesh{
+			.first_vertex = first_vertex,
+			.vertex_count = vertex_count,
+			.first_index = first_index,
+			.index_count = index_count,
+			.bounds = bounds
+		};
+	}
+
+	void GeometryArena::release(Mesh const& mesh, std::uint64_t const retire_value) {
+		m_releases.push_back(Release{ .mesh = mesh, .retire_value = retire_value });
+	}
+
+	void GeometryArena::collect(std::uint64_t const completed_value) {
+		while (!m_releases.empty() && m_releases.front().retire_value <= completed_value) {
+			auto const& mesh = m_releases.front().mesh;
+			m_vertex_ranges.free(mesh.first_vertex, mesh.vertex_count);
+			m_index_ranges.free(mesh.first_index, mesh.index_count);
+			m_releases.pop_front();
+		}
+	}
+
+	void GeometryArena::bind(vk::CommandBuffer const command_buffer) const {
+		command_buffer.bindVertexBuffers(0, m_vertices.get().buffer, vk::DeviceSize{});
+		command_buffer.bindIndexBuffer(m_indices.get().buffer, 0, vk::IndexType::eUint32);
+	}
+}
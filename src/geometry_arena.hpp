@@ -0,0 +1,63 @@
+#pragma once
+#include "vma.hpp"
+#include "range_allocator.hpp"
+#include "upload_queue.hpp"
+#include "defragmenter.hpp"
+#include "utils/object.hpp"
+#include "utils/vertex.hpp"
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <span>
+
+namespace sve {
+	struct GeometryArenaCreateInfo {
+		vma::RawAllocator allocator{};
+		std::uint32_t queue_family{};
+		UploadQueue* uploads{};
+		// moves the arena's buffers when compacting memory, optional
+		Defragmenter* defragmenter{};
+		std::uint32_t vertex_capacity{ 1 << 20 };
+		std::uint32_t index_capacity{ 1 << 22 };
+	};
+
+	// One device local vertex buffer and one index buffer shared by every mesh.
+	// Meshes are element ranges inside them, so a frame binds geometry once.
+	class GeometryArena {
+	public:
+		using CreateInfo = GeometryArenaCreateInfo;
+
+		explicit GeometryArena(CreateInfo const& create_info);
+		~GeometryArena();
+
+		GeometryArena(GeometryArena const&) = delete;
+		GeometryArena& operator=(GeometryArena const&) = delete;
+		GeometryArena(GeometryArena&&) = delete;
+		GeometryArena& operator=(GeometryArena&&) = delete;
+
+		// uploads through the upload queue and fills in the mesh's bounds
+		[[nodiscard]] Mesh create_mesh(std::span<Vertex const> vertices, std::span<std::uint32_t const> indices);
+		// the ranges are handed out again once the frame timeline reaches retire_value
+		void release(Mesh const& mesh, std::uint64_t retire_value);
+		void collect(std::uint64_t completed_value);
+		[[nodiscard]] std::size_t get_pending_releases() const { return m_releases.size(); }
+
+		void bind(vk::CommandBuffer command_buffer) const;
+
+		[[nodiscard]] RangeAllocator const& get_vertex_ranges() const { return m_vertex_ranges; }
+		[[nodiscard]] RangeAllocator const& get_index_ranges() const { return m_index_ranges; }
+
+	private:
+		struct Release {
+			Mesh mesh{};
+			std::uint64_t retire_value{};
+		};
+
+		UploadQueue* m_uploads{};
+		Defragmenter* m_defragmenter{};
+		vma::Buffer m_vertices{};
+		vma::Buffer m_indices{};
+		RangeAllocator m_vertex_ranges{};
+		RangeAllocator m_index_ranges{};
+		std::deque<Release> m_releases{};
+	};
+}
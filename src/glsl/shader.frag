@@ -1,15 +1,13 @@
 #version 450 core
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout (set = 1, binding = 0) uniform sampler2D textures[10];
-
-layout (push_constant) uniform Push{
-	uint textureIndex;
-} pc;
-
+layout (set = 1, binding = 0) uniform sampler2D textures[];
 
+layout (location = 0) in vec4 in_color;
 layout (location = 1) in vec2 in_uv;
+layout (location = 2) flat in uint in_texture_index;
 layout (location = 0) out vec4 out_color;
 
 void main() {
-	out_color = texture(textures[pc.textureIndex], in_uv);
-}
\ No newline at end of file
+	out_color = texture(textures[nonuniformEXT(in_texture_index)], in_uv) * in_color;
+}
@@ -4,20 +4,57 @@ layout (set = 0, binding = 0) uniform View {
   mat4 mat_vp;
 };
 
+// mirrors sve::AffineInstance
+struct AffineInstance {
+    vec2 x_axis;
+    vec2 y_axis;
+    vec2 translation;
+    uint color;
+    uint texture_index;
+};
+
+// both blocks alias the instance ring, push constants select the layout
+layout (set = 2, binding = 0) readonly buffer affines {
+    AffineInstance affine_instances[];
+};
+
 layout (set = 2, binding = 0) readonly buffer matrices {
     mat4 mat_ms[];
 };
 
+const uint instance_format_affine = 0;
+
+layout (push_constant) uniform Push {
+    uint texture_index;
+    uint instance_format;
+} pc;
+
 layout (location = 0) in vec2 a_pos;
 layout (location = 1) in vec3 a_color;
 layout (location = 2) in vec2 a_uv;
 
-layout (location = 0) out vec3 out_color;
+layout (location = 0) out vec4 out_color;
 layout (location = 1) out vec2 out_uv;
+layout (location = 2) flat out uint out_texture_index;
+
+vec3 srgb_to_linear(vec3 c) {
+    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
 
 void main() {
-    vec4 world_pos = vec4(a_pos, 0.0, 1.0);
-    out_color = a_color;
+    vec4 world_pos;
+    vec4 tint = vec4(1.0);
+    out_texture_index = pc.texture_index;
+    if (pc.instance_format == instance_format_affine) {
+        AffineInstance instance = affine_instances[gl_InstanceIndex];
+        world_pos = vec4(instance.x_axis * a_pos.x + instance.y_axis * a_pos.y + instance.translation, 0.0, 1.0);
+        tint = unpackUnorm4x8(instance.color);
+        tint.rgb = srgb_to_linear(tint.rgb);
+        out_texture_index = instance.texture_index;
+    } else {
+        world_pos = mat_ms[gl_InstanceIndex] * vec4(a_pos, 0.0, 1.0);
+    }
+    out_color = vec4(a_color, 1.0) * tint;
     out_uv = a_uv;
-    gl_Position = mat_vp * mat_ms[gl_InstanceIndex] * world_pos;
-}
\ No newline at end of file
+    gl_Position = mat_vp * world_pos;
+}
@@ -1,6 +1,8 @@
 #include "gpu.hpp"
+#include <algorithm>
 #include <ranges>
 #include <print>
+#include <string_view>
 
 namespace sve {
 	Gpu get_suitable_gpu(vk::Instance const instance, vk::SurfaceKHR const surface) {
@@ -25,22 +27,68 @@ namespace sve {
 			return false;
 			};
 
+		auto const set_transfer_queue_family = [](Gpu& out_gpu) {
+			// a family without graphics or compute usually maps to a DMA engine that copies alongside rendering
+			static constexpr auto excluded_flags_v = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+			out_gpu.transfer_queue_family = out_gpu.queue_family;
+			for (auto const [index, family] : std::views::enumerate(out_gpu.device.getQueueFamilyProperties())) {
+				if ((family.queueFlags & vk::QueueFlagBits::eTransfer) && !(family.queueFlags & excluded_flags_v)) {
+					out_gpu.transfer_queue_family = static_cast<std::uint32_t>(index);
+					return;
+				}
+			}
+			};
+
 		auto const can_present = [surface](Gpu const& gpu) {
-			return gpu.device.getSurfaceSupportKHR(gpu.queue_family, surface) == vk::True;
+			return !surface || gpu.device.getSurfaceSupportKHR(gpu.queue_family, surface) == vk::True;
+			};
+
+		// everything the device enables unconditionally from Vulkan 1.2
+		auto const supports_vulkan12_features = [](Gpu const& gpu) {
+			auto vulkan12_features = vk::PhysicalDeviceVulkan12Features{};
+			auto features = vk::PhysicalDeviceFeatures2{};
+			features.setPNext(&vulkan12_features);
+			gpu.device.getFeatures2(&features);
+			auto const ret = vulkan12_features.timelineSemaphore
+				&& vulkan12_features.runtimeDescriptorArray
+				&& vulkan12_features.descriptorBindingPartiallyBound
+				&& vulkan12_features.descriptorBindingSampledImageUpdateAfterBind
+				&& vulkan12_features.descriptorBindingUpdateUnusedWhilePending
+				&& vulkan12_features.shaderSampledImageArrayNonUniformIndexing;
+			if (!ret) std::println(stderr, "[sve] Skipping {}: missing timeline semaphore or descriptor indexing features", std::string_view{ gpu.properties.deviceName });
+			return ret;
+			};
+
+		auto const set_max_bindless_textures = [](Gpu& out_gpu) {
+			auto vulkan12_properties = vk::PhysicalDeviceVulkan12Properties{};
+			auto properties = vk::PhysicalDeviceProperties2{};
+			properties.setPNext(&vulkan12_properties);
+			out_gpu.device.getProperties2(&properties);
+			// a combined image sampler counts as both a sampled image and a sampler
+			out_gpu.max_bindless_textures = std::min({
+				vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+				vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+				vulkan12_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+				vulkan12_properties.maxDescriptorSetUpdateAfterBindSamplers
+			});
 			};
 
 		auto fallback = Gpu{};
 		for (auto const& device : instance.enumeratePhysicalDevices()) {
 			auto gpu = Gpu{ .device = device, .properties = device.getProperties() };
 			if (gpu.properties.apiVersion < vk_version_v) continue;
-			if (!supports_swapchain(gpu)) continue;
+			if (surface && !supports_swapchain(gpu)) continue;
 			if (!set_queue_family(gpu)) continue;
 			if (!can_present(gpu)) continue;
+			if (!supports_vulkan12_features(gpu)) continue;
+			set_transfer_queue_family(gpu);
+			set_max_bindless_textures(gpu);
 			gpu.features = gpu.device.getFeatures();
 			if (gpu.properties.deviceType == vk::PhysicalDeviceType::eIntegratedGpu) {
 				return gpu;
 			}
-			fallback = gpu;
+			// software rasterizers like lavapipe only when there is no hardware device
+			if (!fallback.device || fallback.properties.deviceType == vk::PhysicalDeviceType::eCpu) fallback = gpu;
 		}
 		if (fallback.device) return fallback;
 		throw std::runtime_error{ "No suitable Vulkan physical devices found" };
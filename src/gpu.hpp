@@ -9,7 +9,13 @@ namespace sve {
 		vk::PhysicalDeviceProperties properties{};
 		vk::PhysicalDeviceFeatures features{};
 		std::uint32_t queue_family{};
+		// transfer only family for uploads, queue_family when the device has none
+		std::uint32_t transfer_queue_family{};
+		// update-after-bind combined image samplers a single set and stage may hold
+		std::uint32_t max_bindless_textures{};
 	};
 
+	// a null surface selects a device for headless rendering, which needs neither swapchain nor present support.
+	// devices without timeline semaphores and the descriptor indexing features bindless textures use are skipped
 	[[nodiscard]] Gpu get_suitable_gpu(vk::Instance instance, vk::SurfaceKHR surface);
 }
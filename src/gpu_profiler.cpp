@@ -0,0 +1,95 @@
+#include "gpu_profiler.hpp"
+
+#if SVE_GPU_PROFILER
+#include <algorithm>
+#include <limits>
+
+namespace sve {
+	namespace {
+		constexpr std::uint32_t invalid_index_v{ std::numeric_limits<std::uint32_t>::max() };
+	}
+
+	GpuProfiler::Scope::~Scope() {
+		if (m_index != invalid_index_v) m_profiler->end_scope(m_command_buffer, m_index);
+	}
+
+	GpuProfiler::GpuProfiler(CreateInfo const& create_info)
+		: m_device(create_info.device), m_max_scopes(create_info.max_scopes), m_history(create_info.history_size) {
+		auto const valid_bits = create_info.physical_device.getQueueFamilyProperties().at(create_info.queue_family).timestampValidBits;
+		if (valid_bits == 0 || m_max_scopes == 0) return;
+
+		auto query_pool_ci = vk::QueryPoolCreateInfo{};
+		query_pool_ci.setQueryType(vk::QueryType::eTimestamp)
+			.setQueryCount(first_query(resource_buffering_v));
+		m_pool = m_device.createQueryPoolUnique(query_pool_ci);
+		m_period_ns = create_info.physical_device.getProperties().limits.timestampPeriod;
+		m_mask = valid_bits >= 64 ? ~std::uint64_t{} : (std::uint64_t{ 1 } << valid_bits) - 1;
+
+		for (auto& slot : m_slots) slot.scopes.reserve(m_max_scopes);
+		m_ticks.resize(2 * m_max_scopes);
+		m_results.reserve(m_max_scopes);
+	}
+
+	void GpuProfiler::begin_frame(vk::CommandBuffer const command_buffer, std::size_t const frame_index) {
+		if (!m_pool) return;
+		m_frame_index = frame_index;
+		m_depth = 0;
+		auto& slot = m_slots.at(frame_index);
+		if (slot.written) read_results(frame_index);
+		slot.scopes.clear();
+		slot.written = true;
+		command_buffer.resetQueryPool(*m_pool, first_query(frame_index), 2 * m_max_scopes);
+	}
+
+	GpuProfiler::Scope GpuProfiler::scope(vk::CommandBuffer const command_buffer, std::string_view const name) {
+		auto& scopes = m_slots.at(m_frame_index).scopes;
+		if (!m_pool || scopes.size() >= m_max_scopes) return Scope{ this, command_buffer, invalid_index_v };
+
+		auto const index = static_cast<std::uint32_t>(scopes.size());
+		scopes.push_back(ScopeInfo{ .name = name, .depth = m_depth++ });
+		// all commands before the scope have finished, so nothing earlier is counted towards it
+		command_buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, *m_pool, first_query(m_frame_index) + 2 * index);
+		return Scope{ this, command_buffer, index };
+	}
+
+	void GpuProfiler::end_scope(vk::CommandBuffer const command_buffer, std::uint32_t const index) {
+		--m_depth;
+		command_buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, *m_pool, first_query(m_frame_index) + 2 * index + 1);
+	}
+
+	void GpuProfiler::read_results(std::size_t const frame_index) {
+		auto const& scopes = m_slots.at(frame_index).scopes;
+		if (scopes.empty()) return;
+
+		auto const ticks = std::span{ m_ticks }.first(2 * scopes.size());
+		auto const result = m_device.getQueryPoolResults(*m_pool, first_query(frame_index), static_cast<std::uint32_t>(ticks.size()),
+			ticks.size_bytes(), ticks.data(), sizeof(std::uint64_t), vk::QueryResultFlagBits::e64);
+		// not ready only if the frame was never submitted, keep the previous results
+		if (result != vk::Result::eSuccess) return;
+
+		auto const to_ms = [this](std::uint64_t const begin, std::uint64_t const end) {
+			return static_cast<float>(static_cast<double>((end - begin) & m_mask) * m_period_ns / 1'000'000.0);
+			};
+		auto first = ticks[0];
+		auto last = ticks[1];
+		for (auto i = 0uz; i < scopes.size(); ++i) {
+			first = std::min(first, ticks[2 * i]);
+			last = std::max(last, ticks[2 * i + 1]);
+		}
+		m_results.clear();
+		for (auto i = 0uz; i < scopes.size(); ++i) {
+			m_results.push_back(GpuScopeResult{
+				.name = scopes[i].name,
+				.depth = scopes[i].depth,
+				.begin_ms = to_ms(first, ticks[2 * i]),
+				.ms = to_ms(ticks[2 * i], ticks[2 * i + 1])
+			});
+		}
+		m_frame_ms = to_ms(first, last);
+
+		if (m_history.empty()) return;
+		m_history[m_history_offset] = m_frame_ms;
+		m_history_offset = (m_history_offset + 1) % m_history.size();
+	}
+}
+#endif
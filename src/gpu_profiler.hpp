@@ -0,0 +1,141 @@
+#pragma once
+#include "resource_buffering.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// 1 compiles the profiler in, 0 replaces it with no-ops. Defaults to off in release builds,
+// define it to 1 (eg with the SVE_GPU_PROFILER CMake option) to keep GPU timings there
+#if !defined(SVE_GPU_PROFILER)
+#if defined(NDEBUG)
+#define SVE_GPU_PROFILER 0
+#else
+#define SVE_GPU_PROFILER 1
+#endif
+#endif
+
+namespace sve {
+	struct GpuProfilerCreateInfo {
+		vk::Device device{};
+		vk::PhysicalDevice physical_device{};
+		std::uint32_t queue_family{};
+		// per frame, scopes beyond it are not timed
+		std::uint32_t max_scopes{ 64 };
+		// frames of GPU time kept for plotting
+		std::size_t history_size{ 240 };
+	};
+
+	struct GpuScopeResult {
+		std::string_view name{};
+		// number of enclosing scopes
+		std::uint32_t depth{};
+		// since the first scope of the frame began
+		float begin_ms{};
+		float ms{};
+	};
+
+#if SVE_GPU_PROFILER
+	// Times named scopes with timestamp queries, one range of queries per frame slot. A slot's results
+	// are read when the slot is reused, after begin_frame() waited for its previous frame, so reading
+	// never stalls and results are frames_in_flight frames late. Render thread only.
+	class GpuProfiler {
+	public:
+		using CreateInfo = GpuProfilerCreateInfo;
+
+		// writes the end timestamp when it goes out of scope
+		class Scope {
+		public:
+			Scope(Scope const&) = delete;
+			Scope& operator=(Scope const&) = delete;
+			Scope(Scope&&) = delete;
+			Scope& operator=(Scope&&) = delete;
+
+			~Scope();
+
+		private:
+			friend class GpuProfiler;
+
+			Scope(GpuProfiler* profiler, vk::CommandBuffer command_buffer, std::uint32_t index)
+				: m_profiler(profiler), m_command_buffer(command_buffer), m_index(index) {}
+
+			GpuProfiler* m_profiler{};
+			vk::CommandBuffer m_command_buffer{};
+			std::uint32_t m_index{};
+		};
+
+		explicit GpuProfiler(CreateInfo const& create_info);
+
+		// false if the queue family can't write timestamps, scopes are then no-ops
+		[[nodiscard]] bool is_enabled() const { return static_cast<bool>(m_pool); }
+
+		// record first in the frame's command buffer: publishes the slot's previous results and resets its queries
+		void begin_frame(vk::CommandBuffer command_buffer, std::size_t frame_index);
+		// name is not copied, it must outlive the results, eg a string literal
+		[[nodiscard]] Scope scope(vk::CommandBuffer command_buffer, std::string_view name);
+
+		// scopes of the latest completed frame in the order they were opened
+		[[nodiscard]] std::span<GpuScopeResult const> get_results() const { return m_results; }
+		// first scope begin to last scope end of the latest completed frame
+		[[nodiscard]] float get_frame_ms() const { return m_frame_ms; }
+		// ring of get_frame_ms() values, the oldest is at get_history_offset()
+		[[nodiscard]] std::span<float const> get_history() const { return m_history; }
+		[[nodiscard]] std::size_t get_history_offset() const { return m_history_offset; }
+
+	private:
+		struct ScopeInfo {
+			std::string_view name{};
+			std::uint32_t depth{};
+		};
+
+		struct Slot {
+			std::vector<ScopeInfo> scopes{};
+			bool written{};
+		};
+
+		void end_scope(vk::CommandBuffer command_buffer, std::uint32_t index);
+		void read_results(std::size_t frame_index);
+		[[nodiscard]] std::uint32_t first_query(std::size_t const frame_index) const { return static_cast<std::uint32_t>(frame_index) * 2 * m_max_scopes; }
+
+		vk::Device m_device{};
+		vk::UniqueQueryPool m_pool{};
+		std::uint32_t m_max_scopes{};
+		float m_period_ns{};
+		std::uint64_t m_mask{};
+
+		Buffered<Slot> m_slots{};
+		std::size_t m_frame_index{};
+		std::uint32_t m_depth{};
+		std::vector<std::uint64_t> m_ticks{};
+
+		std::vector<GpuScopeResult> m_results{};
+		float m_frame_ms{};
+		std::vector<float> m_history{};
+		std::size_t m_history_offset{};
+	};
+#else
+	// compiled out, see SVE_GPU_PROFILER
+	class GpuProfiler {
+	public:
+		using CreateInfo = GpuProfilerCreateInfo;
+
+		struct Scope {
+			// user provided so unused scopes don't warn
+			~Scope() {}
+		};
+
+		explicit GpuProfiler(CreateInfo const& /*create_info*/) {}
+
+		[[nodiscard]] bool is_enabled() const { return false; }
+
+		void begin_frame(vk::CommandBuffer /*command_buffer*/, std::size_t /*frame_index*/) {}
+		[[nodiscard]] Scope scope(vk::CommandBuffer /*command_buffer*/, std::string_view /*name*/) { return {}; }
+
+		[[nodiscard]] std::span<GpuScopeResult const> get_results() const { return {}; }
+		[[nodiscard]] float get_frame_ms() const { return 0.0f; }
+		[[nodiscard]] std::span<float const> get_history() const { return {}; }
+		[[nodiscard]] std::size_t get_history_offset() const { return 0; }
+	};
+#endif
+}
@@ -0,0 +1,436 @@
+#include "gpu_scene.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+
+namespace sve {
+	namespace {
+		enum : std::uint32_t {
+			objects_binding_v,
+			draws_binding_v,
+			order_binding_v,
+			entry_offsets_binding_v,
+			group_offsets_binding_v,
+			instances_binding_v,
+			commands_binding_v,
+			command_counts_binding_v,
+			binding_count_v
+		};
+
+		enum : std::uint32_t { cull_phase_v, scan_phase_v, scatter_phase_v, emit_phase_v };
+
+		void memory_barrier(vk::CommandBuffer const command_buffer, vk::MemoryBarrier2 const& barrier) {
+			auto dependency_info = vk::DependencyInfo{};
+			dependency_info.setMemoryBarriers(barrier);
+			command_buffer.pipelineBarrier2(dependency_info);
+		}
+
+		[[nodiscard]] constexpr std::uint32_t group_count(std::uint32_t const count, std::uint32_t const group_size) {
+			return (count + group_size - 1) / group_size;
+		}
+	}
+
+	GpuScene::GpuScene(CreateInfo const& create_info)
+		: m_device(create_info.device), m_resources(create_info.resources), m_max_objects(create_info.max_objects), m_max_draws(create_info.max_draws) {
+		create_buffers(create_info);
+		create_descriptor_sets(create_info);
+		create_cull_shader(create_info);
+	}
+
+	void GpuScene::create_buffers(CreateInfo const& create_info) {
+		auto buffer_ci = vma::BufferCreateInfo{
+			.allocator = create_info.allocator,
+			.usage = vk::BufferUsageFlagBits::eStorageBuffer,
+			.queue_family = create_info.queue_family
+		};
+		m_objects_buffer = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, m_max_objects * sizeof(GpuObject));
+		m_order_buffer = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, m_max_objects * sizeof(std::uint32_t));
+
+		auto const draw_count_bytes = vk::DeviceSize{ m_max_draws * sizeof(std::uint32_t) };
+		auto const group_offset_bytes = vk::DeviceSize{ (group_count(m_max_objects, workgroup_size_v) + 1) * sizeof(std::uint32_t) };
+		for (auto& frame : m_frames) {
+			// rewritten by the CPU every frame, small enough to live in host memory
+			buffer_ci.usage = vk::BufferUsageFlagBits::eStorageBuffer;
+			frame.draws = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Host, m_max_draws * sizeof(GpuDraw));
+			frame.instances = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, m_max_objects * sizeof(AffineInstance));
+			frame.entry_offsets = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, m_max_objects * sizeof(std::uint32_t));
+			frame.group_offsets = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, group_offset_bytes);
+
+			buffer_ci.usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer;
+			frame.commands = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, m_max_draws * sizeof(vk::DrawIndexedIndirectCommand));
+			frame.command_counts = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Device, draw_count_bytes);
+		}
+
+		auto const staging_ci = RingBuffer::CreateInfo{
+			.allocator = create_info.allocator,
+			.queue_family = create_info.queue_family,
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.alignment = sizeof(GpuObject)
+		};
+		m_staging.emplace(staging_ci);
+	}
+
+	void GpuScene::create_descriptor_sets(CreateInfo const& create_info) {
+		static constexpr auto frame_count_v = static_cast<std::uint32_t>(resource_buffering_v);
+		auto const pool_sizes = std::array{
+			vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, binding_count_v * frame_count_v },
+			vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBufferDynamic, frame_count_v },
+		};
+		auto pool_ci = vk::DescriptorPoolCreateInfo{};
+		pool_ci.setPoolSizes(pool_sizes).setMaxSets(2 * frame_count_v);
+		m_descriptor_pool = m_device.createDescriptorPoolUnique(pool_ci);
+
+		auto bindings = std::array<vk::DescriptorSetLayoutBinding, binding_count_v>{};
+		for (auto i = 0u; i < binding_count_v; ++i) {
+			bindings[i] = vk::DescriptorSetLayoutBinding{ i, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute };
+		}
+		auto set_layout_ci = vk::DescriptorSetLayoutCreateInfo{};
+		set_layout_ci.setBindings(bindings);
+		m_cull_set_layout = m_device.createDescriptorSetLayoutUnique(set_layout_ci);
+
+		auto const layouts = std::array{ *m_cull_set_layout, create_info.instance_set_layout };
+		for (auto& frame : m_frames) {
+			auto allocate_info = vk::DescriptorSetAllocateInfo{};
+			allocate_info.setDescriptorPool(*m_descriptor_pool).setSetLayouts(layouts);
+			auto const sets = m_device.allocateDescriptorSets(allocate_info);
+			frame.cull_set = sets[0];
+			frame.instance_set = sets[1];
+
+			// every buffer has a fixed size, so the sets are written once
+			auto const whole = [](vma::Buffer const& buffer) {
+				return vk::DescriptorBufferInfo{ buffer.get().buffer, 0, vk::WholeSize };
+			};
+			auto const buffer_infos = std::array{
+				whole(m_objects_buffer), whole(frame.draws), whole(m_order_buffer), whole(frame.entry_offsets),
+				whole(frame.group_offsets), whole(frame.instances), whole(frame.commands), whole(frame.command_counts)
+			};
+			auto writes = std::array<vk::WriteDescriptorSet, binding_count_v + 1>{};
+			for (auto i = 0u; i < binding_count_v; ++i) {
+				writes[i].setDstSet(frame.cull_set)
+					.setDstBinding(i)
+					.setDescriptorType(vk::DescriptorType::eStorageBuffer)
+					.setBufferInfo(buffer_infos[i]);
+			}
+			writes.back().setDstSet(frame.instance_set)
+				.setDstBinding(0)
+				.setDescriptorType(vk::DescriptorType::eStorageBufferDynamic)
+				.setBufferInfo(buffer_infos[instances_binding_v]);
+			m_device.updateDescriptorSets(writes, {});
+		}
+	}
+
+	void GpuScene::create_cull_shader(CreateInfo const& create_info) {
+		static constexpr auto push_constant_range_v = vk::PushConstantRange{ vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants) };
+
+		auto pipeline_layout_ci = vk::PipelineLayoutCreateInfo{};
+		pipeline_layout_ci.setSetLayouts(*m_cull_set_layout)
+			.setPushConstantRanges(push_constant_range_v);
+		m_pipeline_layout = m_device.createPipelineLayoutUnique(pipeline_layout_ci);
+
+		auto shader_ci = vk::ShaderCreateInfoEXT{};
+		shader_ci.setStage(vk::ShaderStageFlagBits::eCompute)
+			.setCodeType(vk::ShaderCodeTypeEXT::eSpirv)
+			.setCodeSize(create_info.cull_spirv.size_bytes())
+			.setPCode(create_info.cull_spirv.data())
+			.setSetLayouts(*m_cull_set_layout)
+			.setPushConstantRanges(push_constant_range_v)
+			.setPName("main");
+		auto result = m_device.createShadersEXTUnique(shader_ci);
+		if (result.result != vk::Result::eSuccess) {
+			throw std::runtime_error{ "Failed to create cull shader object" };
+		}
+		m_cull_shader = std::move(result.value.front());
+	}
+
+	std::uint32_t GpuScene::add(Object const& object) {
+		auto id = std::uint32_t{};
+		if (!m_free_ids.empty()) {
+			id = m_free_ids.back();
+			m_free_ids.pop_back();
+		}
+		else {
+			if (m_objects.size() >= m_max_objects) {
+				throw std::runtime_error{ "GPU scene is full" };
+			}
+			id = static_cast<std::uint32_t>(m_objects.size());
+			m_objects.emplace_back();
+			m_is_dirty.push_back(false);
+		}
+
+		m_objects[id] = to_gpu_object(object);
+		++m_draws[m_objects[id].draw_index].object_count;
+		mark_dirty(id);
+		m_order_dirty = true;
+		return id;
+	}
+
+	void GpuScene::update(std::uint32_t const id, Object const& object) {
+		auto& gpu_object = m_objects.at(id);
+		assert(gpu_object.draw_index != invalid_draw_v);
+		// joins the new draw first, an object that keeps its draw must not release it
+		auto const previous_draw = gpu_object.draw_index;
+		gpu_object = to_gpu_object(object);
+		++m_draws[gpu_object.draw_index].object_count;
+		remove_from_draw(previous_draw);
+		mark_dirty(id);
+		m_order_dirty |= gpu_object.draw_index != previous_draw;
+	}
+
+	void GpuScene::remove(std::uint32_t const id) {
+		auto& gpu_object = m_objects.at(id);
+		assert(gpu_object.draw_index != invalid_draw_v);
+		remove_from_draw(gpu_object.draw_index);
+		// the slot stays in the buffer until reused, the rebuilt order no longer refers to it
+		gpu_object.draw_index = invalid_draw_v;
+		m_free_ids.push_back(id);
+		m_order_dirty = true;
+	}
+
+	GpuObject GpuScene::to_gpu_object(Object const& object) {
+		auto const& transform = object.transform;
+		auto const& bounds = m_resources->get(object.mesh).bounds;
+		auto const radians = glm::radians(transform.rotation);
+		auto const s = glm::sin(radians);
+		auto const c = glm::cos(radians);
+		return GpuObject{
+			.instance = AffineInstance{
+				.x_axis = glm::vec2{ c, s } * transform.scale.x,
+				.y_axis = glm::vec2{ -s, c } * transform.scale.y,
+				.translation = transform.position,
+				.color = object.color.to_rgba8(),
+				.texture_index = m_resources->get(object.material.texture).get_index()
+			},
+			.bounds_center = bounds.center(),
+			.bounds_half_extent = bounds.half_extent(),
+			.draw_index = get_draw_index(object)
+		};
+	}
+
+	std::uint32_t GpuScene::get_draw_index(Object const& object) {
+		auto const key = std::pair{ object.material.shader, object.mesh };
+		if (auto const it = m_draw_indices.find(key); it != m_draw_indices.end()) return it->second;
+
+		auto const draw = DrawInfo{ .shader = key.first, .mesh = key.second, .alive = true };
+		auto ret = std::uint32_t{};
+		if (!m_free_draws.empty()) {
+			ret = m_free_draws.back();
+			m_free_draws.pop_back();
+			m_draws[ret] = draw;
+		}
+		else {
+			if (m_draws.size() >= m_max_draws) {
+				throw std::runtime_error{ "GPU scene has too many draws" };
+			}
+			ret = static_cast<std::uint32_t>(m_draws.size());
+			m_draws.push_back(draw);
+		}
+		m_draw_indices.emplace(key, ret);
+		assign_segment(ret);
+		return ret;
+	}
+
+	void GpuScene::assign_segment(std::uint32_t const draw_index) {
+		auto& draw = m_draws[draw_index];
+		// every mesh lives in the geometry arena, so only the shader splits segments
+		auto it = std::ranges::find(m_segments, draw.shader, &GpuSegment::shader);
+		if (it == m_segments.end()) {
+			m_segments.push_back(GpuSegment{ .shader = draw.shader });
+			it = std::prev(m_segments.end());
+		}
+		++it->draw_count;
+		draw.segment = static_cast<std::uint32_t>(std::distance(m_segments.begin(), it));
+		update_first_commands();
+	}
+
+	void GpuScene::remove_from_draw(std::uint32_t const draw_index) {
+		auto& draw = m_draws[draw_index];
+		assert(draw.alive && draw.object_count > 0);
+		if (--draw.object_count > 0) return;
+
+		m_draw_indices.erase(std::pair{ draw.shader, draw.mesh });
+		draw.alive = false;
+		m_free_draws.push_back(draw_index);
+
+		auto const segment = draw.segment;
+		if (--m_segments[segment].draw_count == 0) {
+			m_segments.erase(m_segments.begin() + segment);
+			for (auto& other : m_draws) {
+				if (other.alive && other.segment > segment) --other.segment;
+			}
+		}
+		update_first_commands();
+	}
+
+	void GpuScene::update_first_commands() {
+		// segments own contiguous command ranges
+		auto first_command = std::uint32_t{};
+		for (auto& segment : m_segments) {
+			segment.first_command = first_command;
+			first_command += segment.draw_count;
+		}
+	}
+
+	void GpuScene::mark_dirty(std::uint32_t const id) {
+		if (m_is_dirty[id]) return;
+		m_is_dirty[id] = true;
+		m_dirty_ids.push_back(id);
+	}
+
+	void GpuScene::upload_objects(vk::CommandBuffer const command_buffer) {
+		if (m_dirty_ids.empty()) return;
+		std::ranges::sort(m_dirty_ids);
+
+		auto const staging = m_staging->allocate<GpuObject>(m_dirty_ids.size());
+		auto const staging_buffer = m_staging->get_descriptor_info().buffer;
+		auto const staging_base = m_staging->get_dynamic_offset() + staging.first_element * sizeof(GpuObject);
+
+		// adjacent ids are coalesced into one copy region
+		m_copies.clear();
+		for (auto i = 0uz; i < m_dirty_ids.size(); ++i) {
+			auto const id = m_dirty_ids[i];
+			staging.data[i] = m_objects[id];
+			m_is_dirty[id] = false;
+
+			auto const src_offset = staging_base + i * sizeof(GpuObject);
+			auto const dst_offset = vk::DeviceSize{ id * sizeof(GpuObject) };
+			if (!m_copies.empty() && m_copies.back().dstOffset + m_copies.back().size == dst_offset) {
+				m_copies.back().size += sizeof(GpuObject);
+				continue;
+			}
+			m_copies.push_back(vk::BufferCopy2{ src_offset, dst_offset, sizeof(GpuObject) });
+		}
+		m_dirty_ids.clear();
+
+		// the previous frame's cull pass may still read the objects
+		auto barrier = vk::MemoryBarrier2{};
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+			.setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		memory_barrier(command_buffer, barrier);
+
+		auto copy_info = vk::CopyBufferInfo2{};
+		copy_info.setSrcBuffer(staging_buffer)
+			.setDstBuffer(m_objects_buffer.get().buffer)
+			.setRegions(m_copies);
+		command_buffer.copyBuffer2(copy_info);
+	}
+
+	void GpuScene::upload_order(vk::CommandBuffer const command_buffer) {
+		if (!m_order_dirty) return;
+		m_order_dirty = false;
+
+		// counting sort by draw, walking the ids in ascending order keeps each draw sorted by id
+		m_draw_cursors.resize(m_draws.size());
+		auto first_entry = std::uint32_t{};
+		for (auto const [draw, cursor] : std::views::zip(m_draws, m_draw_cursors)) {
+			cursor = first_entry;
+			first_entry += draw.object_count;
+		}
+		m_order.resize(first_entry);
+		for (auto const [id, object] : std::views::enumerate(m_objects)) {
+			if (object.draw_index == invalid_draw_v) continue;
+			m_order[m_draw_cursors[object.draw_index]++] = static_cast<std::uint32_t>(id);
+		}
+		if (m_order.empty()) return;
+
+		auto const staging = m_staging->allocate<std::uint32_t>(m_order.size());
+		std::ranges::copy(m_order, staging.data.begin());
+		auto const region = vk::BufferCopy2{
+			m_staging->get_dynamic_offset() + staging.first_element * sizeof(std::uint32_t), 0, std::span{ m_order }.size_bytes()
+		};
+
+		// the previous frame's cull pass may still read the order
+		auto barrier = vk::MemoryBarrier2{};
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+			.setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		memory_barrier(command_buffer, barrier);
+
+		auto copy_info = vk::CopyBufferInfo2{};
+		copy_info.setSrcBuffer(m_staging->get_descriptor_info().buffer)
+			.setDstBuffer(m_order_buffer.get().buffer)
+			.setRegions(region);
+		command_buffer.copyBuffer2(copy_info);
+	}
+
+	void GpuScene::write_draws(FrameResources const& frame) {
+		auto* out = static_cast<GpuDraw*>(frame.draws.get().mapped);
+		// the same ranges upload_order() grouped the objects into
+		auto first_entry = std::uint32_t{};
+		for (auto const& draw : m_draws) {
+			// released draws have no objects and their mesh may be gone, the cull pass never emits them
+			if (!draw.alive) {
+				*out++ = GpuDraw{ .first_entry = first_entry };
+				continue;
+			}
+			auto const& mesh = m_resources->get(draw.mesh);
+			*out++ = GpuDraw{
+				.index_count = mesh.index_count,
+				.first_index = mesh.first_index,
+				.vertex_offset = static_cast<std::int32_t>(mesh.first_vertex),
+				.first_entry = first_entry,
+				.entry_count = draw.object_count,
+				.segment = draw.segment,
+				.first_command = m_segments[draw.segment].first_command
+			};
+			first_entry += draw.object_count;
+		}
+	}
+
+	void GpuScene::cull(vk::CommandBuffer const command_buffer, std::size_t const frame_index, Rect const& view) {
+		auto& frame = m_frames.at(frame_index);
+		m_staging->begin_frame(frame_index);
+		upload_objects(command_buffer);
+		upload_order(command_buffer);
+		write_draws(frame);
+
+		auto const draw_count = static_cast<std::uint32_t>(m_draws.size());
+		auto const count_bytes = vk::DeviceSize{ std::max(draw_count, 1u) * sizeof(std::uint32_t) };
+		command_buffer.fillBuffer(frame.command_counts.get().buffer, 0, count_bytes, 0);
+
+		auto barrier = vk::MemoryBarrier2{};
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy | vk::PipelineStageFlagBits2::eClear)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+			.setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+		memory_barrier(command_buffer, barrier);
+
+		auto const stage = vk::ShaderStageFlagBits::eCompute;
+		command_buffer.bindShadersEXT(stage, *m_cull_shader);
+		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipeline_layout, 0, frame.cull_set, {});
+
+		auto push_constants = PushConstants{
+			.view_min = view.min,
+			.view_max = view.max,
+			.entry_count = static_cast<std::uint32_t>(m_order.size()),
+			.draw_count = draw_count,
+			.phase = cull_phase_v
+		};
+		auto const entry_groups = group_count(push_constants.entry_count, workgroup_size_v);
+		auto const dispatch = [&](std::uint32_t const phase, std::uint32_t const groups) {
+			push_constants.phase = phase;
+			command_buffer.pushConstants(*m_pipeline_layout, stage, 0, sizeof(push_constants), &push_constants);
+			command_buffer.dispatch(groups, 1, 1);
+		};
+
+		barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+			.setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite);
+
+		// survivors are counted per workgroup, the group counts are scanned, then both passes
+		// read the offsets: scatter compacts the instances while emit builds one command per draw
+		dispatch(cull_phase_v, entry_groups);
+		memory_barrier(command_buffer, barrier);
+		dispatch(scan_phase_v, 1);
+		memory_barrier(command_buffer, barrier);
+		dispatch(scatter_phase_v, entry_groups);
+		dispatch(emit_phase_v, 1);
+
+		barrier.setDstStageMask(vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eVertexShader)
+			.setDstAccessMask(vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead);
+		memory_barrier(command_buffer, barrier);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+#include "vma.hpp"
+#include "ring_buffer.hpp"
+#include "resource_buffering.hpp"
+#include "utils/instance.hpp"
+#include "utils/object.hpp"
+#include "resource_registry.hpp"
+#include "utils/rect.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <span>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace sve {
+	// mirrors the structs in cull.comp, std430
+	struct GpuObject {
+		AffineInstance instance{};
+		glm::vec2 bounds_center{};
+		glm::vec2 bounds_half_extent{};
+		std::uint32_t draw_index{};
+		std::uint32_t padding[3]{};
+	};
+	static_assert(sizeof(GpuObject) == 64);
+
+	struct GpuDraw {
+		std::uint32_t index_count{};
+		std::uint32_t first_index{};
+		std::int32_t vertex_offset{};
+		// range of the draw's objects in the order buffer
+		std::uint32_t first_entry{};
+		std::uint32_t entry_count{};
+		std::uint32_t segment{};
+		std::uint32_t first_command{};
+		std::uint32_t padding{};
+	};
+	static_assert(sizeof(GpuDraw) == 32);
+
+	// draws sharing a shader, consumed by one drawIndexedIndirectCount
+	struct GpuSegment {
+		ShaderHandle shader{};
+		std::uint32_t first_command{};
+		std::uint32_t draw_count{};
+	};
+
+	struct GpuSceneCreateInfo {
+		vk::Device device{};
+		vma::RawAllocator allocator{};
+		std::uint32_t queue_family{};
+		ResourceRegistry const* resources{};
+		std::span<std::uint32_t const> cull_spirv{};
+		// layout of the instance set the vertex shader reads, a single dynamic storage buffer
+		vk::DescriptorSetLayout instance_set_layout{};
+		std::uint32_t max_objects{ 1 << 16 };
+		std::uint32_t max_draws{ 256 };
+	};
+
+	// Persistent objects resident in device memory. Only added, changed and removed objects are
+	// uploaded; a compute pass culls them against the view every frame and compacts the survivors
+	// and their indirect commands, so the CPU cost per frame does not depend on the object count.
+	// The 2D renderer has no depth, so draw order is overlap order: survivors are compacted with a
+	// prefix sum over the objects grouped by draw in id order, and commands follow draw order, so
+	// overlapping objects keep their order from frame to frame.
+	class GpuScene {
+	public:
+		using CreateInfo = GpuSceneCreateInfo;
+
+		static constexpr std::uint32_t invalid_draw_v{ 0xffffffff };
+		static constexpr std::uint32_t workgroup_size_v{ 64 };
+
+		explicit GpuScene(CreateInfo const& create_info);
+
+		// objects are not retained, their mesh and shader must stay registered while the object is in the scene.
+		// once the last object using them is removed they may be destroyed
+		[[nodiscard]] std::uint32_t add(Object const& object);
+		void update(std::uint32_t id, Object const& object);
+		void remove(std::uint32_t id);
+
+		// uploads pending changes and records the cull dispatches, must be recorded outside rendering
+		void cull(vk::CommandBuffer command_buffer, std::size_t frame_index, Rect const& view);
+
+		[[nodiscard]] std::span<GpuSegment const> get_segments() const { return m_segments; }
+		[[nodiscard]] vk::Buffer get_command_buffer(std::size_t const frame_index) const { return m_frames.at(frame_index).commands.get().buffer; }
+		[[nodiscard]] vk::Buffer get_count_buffer(std::size_t const frame_index) const { return m_frames.at(frame_index).command_counts.get().buffer; }
+		[[nodiscard]] vk::DescriptorSet get_instance_set(std::size_t const frame_index) const { return m_frames.at(frame_index).instance_set; }
+		[[nodiscard]] std::uint32_t get_object_count() const { return static_cast<std::uint32_t>(m_objects.size() - m_free_ids.size()); }
+		[[nodiscard]] bool empty() const { return get_object_count() == 0; }
+
+	private:
+		struct PushConstants {
+			glm::vec2 view_min{};
+			glm::vec2 view_max{};
+			std::uint32_t entry_count{};
+			std::uint32_t draw_count{};
+			std::uint32_t phase{};
+			std::uint32_t padding{};
+		};
+
+		// released once its last object leaves, the index is then reused by the next new draw
+		struct DrawInfo {
+			ShaderHandle shader{};
+			MeshHandle mesh{};
+			std::uint32_t segment{};
+			std::uint32_t object_count{};
+			bool alive{};
+		};
+
+		struct FrameResources {
+			vma::Buffer draws{};
+			// per entry, its survivor offset within the workgroup and whether it survived
+			vma::Buffer entry_offsets{};
+			// per workgroup, the survivors before it, followed by the total
+			vma::Buffer group_offsets{};
+			vma::Buffer instances{};
+			vma::Buffer commands{};
+			vma::Buffer command_counts{};
+			vk::DescriptorSet cull_set{};
+			vk::DescriptorSet instance_set{};
+		};
+
+		void create_buffers(CreateInfo const& create_info);
+		void create_descriptor_sets(CreateInfo const& create_info);
+		void create_cull_shader(CreateInfo const& create_info);
+
+		[[nodiscard]] std::uint32_t get_draw_index(Object const& object);
+		[[nodiscard]] GpuObject to_gpu_object(Object const& object);
+		void assign_segment(std::uint32_t draw_index);
+		// releases the draw and its segment once they are empty, so their handles are never used again
+		void remove_from_draw(std::uint32_t draw_index);
+		void update_first_commands();
+		void mark_dirty(std::uint32_t id);
+		void upload_objects(vk::CommandBuffer command_buffer);
+		// regroups the live objects by draw when membership changed and uploads them
+		void upload_order(vk::CommandBuffer command_buffer);
+		void write_draws(FrameResources const& frame);
+
+		vk::Device m_device{};
+		ResourceRegistry const* m_resources{};
+		std::uint32_t m_max_objects{};
+		std::uint32_t m_max_draws{};
+
+		vk::UniqueDescriptorPool m_descriptor_pool{};
+		vk::UniqueDescriptorSetLayout m_cull_set_layout{};
+		vk::UniquePipelineLayout m_pipeline_layout{};
+		vk::UniqueShaderEXT m_cull_shader{};
+
+		vma::Buffer m_objects_buffer{};
+		// ids of the live objects grouped by draw in draw index order, ascending within a draw
+		vma::Buffer m_order_buffer{};
+		std::optional<RingBuffer> m_staging{};
+		Buffered<FrameResources> m_frames{};
+
+		std::vector<GpuObject> m_objects{};
+		std::vector<std::uint32_t> m_free_ids{};
+		std::vector<std::uint32_t> m_dirty_ids{};
+		std::vector<bool> m_is_dirty{};
+		std::vector<std::uint32_t> m_order{};
+		// next order entry of each draw while the order is rebuilt
+		std::vector<std::uint32_t> m_draw_cursors{};
+		bool m_order_dirty{};
+
+		std::vector<DrawInfo> m_draws{};
+		std::vector<std::uint32_t> m_free_draws{};
+		std::map<std::pair<ShaderHandle, MeshHandle>, std::uint32_t> m_draw_indices{};
+		std::vector<GpuSegment> m_segments{};
+		std::vector<vk::BufferCopy2> m_copies{};
+	};
+}
@@ -0,0 +1,202 @@
+#include "job_system.hpp"
+#include "cpu_profiler.hpp"
+#include <bit>
+#include <cassert>
+#include <format>
+#include <stdexcept>
+
+namespace sve {
+	namespace {
+		// Chase-Lev deque as formulated for weak memory models by Le, Pop, Cohen and Zappa Nardelli.
+		// Only the owner pushes and pops at the bottom, any thread may steal from the top.
+		class WorkStealingDeque {
+		public:
+			explicit WorkStealingDeque(std::uint32_t const capacity)
+				: m_buffer(std::bit_ceil(capacity)), m_mask(std::bit_ceil(capacity) - 1) {}
+
+			[[nodiscard]] bool push(Job const* job) {
+				auto const bottom = m_bottom.load(std::memory_order_relaxed);
+				auto const top = m_top.load(std::memory_order_acquire);
+				if (bottom - top > static_cast<std::int64_t>(m_mask)) return false;
+				slot(bottom).store(job, std::memory_order_relaxed);
+				// publishes the job to thieves, which acquire bottom
+				m_bottom.store(bottom + 1, std::memory_order_release);
+				return true;
+			}
+
+			[[nodiscard]] Job const* pop() {
+				auto const bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+				m_bottom.store(bottom, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				auto top = m_top.load(std::memory_order_relaxed);
+				if (top > bottom) {
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+					return nullptr;
+				}
+				auto const* job = slot(bottom).load(std::memory_order_relaxed);
+				if (top == bottom) {
+					// last job, race the thieves for it
+					if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						job = nullptr;
+					}
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+
+			[[nodiscard]] Job const* steal() {
+				auto top = m_top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				auto const bottom = m_bottom.load(std::memory_order_acquire);
+				if (top >= bottom) return nullptr;
+				auto const* job = slot(top).load(std::memory_order_relaxed);
+				if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					return nullptr;
+				}
+				return job;
+			}
+
+		private:
+			[[nodiscard]] std::atomic<Job const*>& slot(std::int64_t const index) {
+				return m_buffer[static_cast<std::size_t>(index) & m_mask];
+			}
+
+			alignas(64) std::atomic<std::int64_t> m_top{};
+			alignas(64) std::atomic<std::int64_t> m_bottom{};
+			std::vector<std::atomic<Job const*>> m_buffer;
+			std::size_t m_mask;
+		};
+
+		struct ThreadBinding {
+			JobSystem const* system{};
+			std::uint32_t index{};
+		};
+
+		thread_local auto t_binding = ThreadBinding{};
+
+		constexpr std::uint32_t spins_before_sleep_v{ 64 };
+	}
+
+	struct JobSystem::Worker {
+		explicit Worker(std::uint32_t const capacity, std::uint32_t const index) : deque(capacity), index(index) {}
+
+		WorkStealingDeque deque;
+		std::uint32_t index{};
+		// start point for choosing steal victims, spreads thieves over the workers
+		std::uint32_t next_victim{};
+	};
+
+	JobSystem::JobSystem(CreateInfo const& create_info) {
+		auto thread_count = create_info.thread_count;
+		if (thread_count == 0) thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+		m_workers.reserve(thread_count);
+		for (auto i = 0u; i < thread_count; ++i) {
+			m_workers.push_back(std::make_unique<Worker>(create_info.queue_capacity, i));
+			m_workers.back()->next_victim = i + 1;
+		}
+
+		t_binding = ThreadBinding{ .system = this, .index = 0 };
+		m_threads.reserve(thread_count - 1);
+		for (auto i = 1u; i < thread_count; ++i) {
+			m_threads.emplace_back([this, i](std::stop_token const& stop) { work(stop, i); });
+		}
+	}
+
+	JobSystem::~JobSystem() {
+		for (auto& thread : m_threads) thread.request_stop();
+		m_epoch.fetch_add(1);
+		m_epoch.notify_all();
+		m_threads.clear();
+		if (t_binding.system == this) t_binding = {};
+	}
+
+	std::uint32_t JobSystem::get_worker_index() const {
+		assert(t_binding.system == this);
+		return t_binding.index;
+	}
+
+	JobSystem::Worker& JobSystem::current_worker() const {
+		if (t_binding.system != this) {
+			throw std::runtime_error{ "Jobs can only be submitted from worker threads" };
+		}
+		return *m_workers[t_binding.index];
+	}
+
+	void JobSystem::run(std::span<Job const> jobs, JobCounter& counter) {
+		if (jobs.empty()) return;
+		auto& worker = current_worker();
+		counter.m_value.fetch_add(static_cast<std::uint32_t>(jobs.size()), std::memory_order_relaxed);
+		for (auto const& job : jobs) {
+			assert(job.counter == &counter);
+			// a full deque degrades to running inline instead of failing
+			if (!worker.deque.push(&job)) execute(job);
+		}
+
+		m_epoch.fetch_add(1);
+		if (m_sleeping.load() > 0) m_epoch.notify_all();
+	}
+
+	void JobSystem::wait(JobCounter const& counter) {
+		auto& worker = current_worker();
+		auto idle_spins = 0u;
+		while (!counter.is_done()) {
+			if (auto const* job = find_job(worker)) {
+				execute(*job);
+				idle_spins = 0;
+				continue;
+			}
+			// the remaining jobs are running elsewhere
+			if (++idle_spins >= spins_before_sleep_v) std::this_thread::yield();
+		}
+	}
+
+	Job const* JobSystem::find_job(Worker& worker) const {
+		if (auto const* job = worker.deque.pop()) return job;
+		auto const count = get_thread_count();
+		for (auto i = 0u; i < count; ++i) {
+			auto const victim = (worker.next_victim + i) % count;
+			if (victim == worker.index) continue;
+			if (auto const* job = m_workers[victim]->deque.steal()) {
+				worker.next_victim = victim;
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void JobSystem::execute(Job const& job) {
+		// the job may live in the waiter's stack frame, read the counter before it can return
+		auto* counter = job.counter;
+		job.entry(job.context, job.first, job.count);
+		counter->m_value.fetch_sub(1, std::memory_order_release);
+	}
+
+	void JobSystem::work(std::stop_token const& stop, std::uint32_t const index) {
+		t_binding = ThreadBinding{ .system = this, .index = index };
+		cpu_profiler::set_thread_name(std::format("Worker {}", index));
+		auto& worker = *m_workers[index];
+		auto idle_spins = 0u;
+		while (!stop.stop_requested()) {
+			if (auto const* job = find_job(worker)) {
+				execute(*job);
+				idle_spins = 0;
+				continue;
+			}
+			if (++idle_spins < spins_before_sleep_v) continue;
+
+			// announce sleeping before the last look, so a submitter either sees us or we see its job
+			m_sleeping.fetch_add(1);
+			auto const epoch = m_epoch.load();
+			if (auto const* job = find_job(worker)) {
+				m_sleeping.fetch_sub(1);
+				execute(*job);
+				idle_spins = 0;
+				continue;
+			}
+			if (!stop.stop_requested()) m_epoch.wait(epoch);
+			m_sleeping.fetch_sub(1);
+			idle_spins = 0;
+		}
+	}
+}
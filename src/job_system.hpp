@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace sve {
+	// number of jobs still outstanding, JobSystem::wait() runs other jobs until it drops to zero
+	class JobCounter {
+	public:
+		[[nodiscard]] bool is_done() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+		std::atomic<std::uint32_t> m_value{};
+	};
+
+	// trivially copyable unit of work, context must outlive the job
+	struct Job {
+		void (*entry)(void const* context, std::size_t first, std::size_t count){};
+		void const* context{};
+		std::size_t first{};
+		std::size_t count{};
+		JobCounter* counter{};
+	};
+
+	struct JobSystemCreateInfo {
+		// worker threads including the creating one, 0 picks the hardware concurrency
+		std::uint32_t thread_count{};
+		// per-worker deque size, jobs beyond it run inline on the submitting thread
+		std::uint32_t queue_capacity{ 4096 };
+	};
+
+	// Work-stealing scheduler: every worker owns a Chase-Lev deque, pushes and pops at its bottom
+	// and steals from the top of the others when it runs dry. The creating thread is worker 0;
+	// jobs may only be submitted and waited on from worker threads, nested waits are fine.
+	class JobSystem {
+	public:
+		using CreateInfo = JobSystemCreateInfo;
+
+		// ranges are cut into at most this many chunks per thread, enough to balance uneven work
+		static constexpr std::size_t chunks_per_thread_v{ 4 };
+
+		explicit JobSystem(CreateInfo const& create_info = {});
+		~JobSystem();
+
+		JobSystem(JobSystem const&) = delete;
+		JobSystem& operator=(JobSystem const&) = delete;
+
+		void run(std::span<Job const> jobs, JobCounter& counter);
+		// executes queued jobs on the calling thread until counter is done
+		void wait(JobCounter const& counter);
+
+		// calls func(first, count) over [0, count) in chunks of at least grain items and returns when all are done
+		template <typename Func>
+		void parallel_for(std::size_t const count, std::size_t const grain, Func const& func) {
+			auto const chunk_count = get_chunk_count(count, grain);
+			if (chunk_count == 0) return;
+			if (chunk_count == 1) {
+				func(0uz, count);
+				return;
+			}
+
+			static constexpr auto entry = [](void const* context, std::size_t const first, std::size_t const count) {
+				(*static_cast<Func const*>(context))(first, count);
+				};
+			// jobs live on the stack for typical thread counts
+			auto buffer = std::array<std::byte, 64 * sizeof(Job)>{};
+			auto resource = std::pmr::monotonic_buffer_resource{ buffer.data(), buffer.size() };
+			auto jobs = std::pmr::vector<Job>{ &resource };
+			jobs.reserve(chunk_count - 1);
+
+			auto counter = JobCounter{};
+			auto const chunk_size = count / chunk_count;
+			auto const remainder = count % chunk_count;
+			auto first = chunk_size + (remainder > 0 ? 1 : 0);
+			for (auto chunk = 1uz; chunk < chunk_count; ++chunk) {
+				auto const size = chunk_size + (chunk < remainder ? 1 : 0);
+				jobs.push_back(Job{ .entry = entry, .context = &func, .first = first, .count = size, .counter = &counter });
+				first += size;
+			}
+			run(jobs, counter);
+			func(0uz, chunk_size + (remainder > 0 ? 1 : 0));
+			wait(counter);
+		}
+
+		[[nodiscard]] std::size_t get_chunk_count(std::size_t const count, std::size_t const grain) const {
+			if (count == 0) return 0;
+			auto const max_chunks = std::size_t{ get_thread_count() } * chunks_per_thread_v;
+			return std::clamp((count + grain - 1) / std::max(grain, 1uz), 1uz, max_chunks);
+		}
+
+		[[nodiscard]] std::uint32_t get_thread_count() const { return static_cast<std::uint32_t>(m_workers.size()); }
+		// index of the calling worker thread in [0, get_thread_count())
+		[[nodiscard]] std::uint32_t get_worker_index() const;
+
+	private:
+		struct Worker;
+
+		[[nodiscard]] Worker& current_worker() const;
+		[[nodiscard]] Job const* find_job(Worker& worker) const;
+		static void execute(Job const& job);
+		void work(std::stop_token const& stop, std::uint32_t index);
+
+		std::vector<std::unique_ptr<Worker>> m_workers{};
+
+		// bumped on every submission, idle workers sleep on it
+		std::atomic<std::uint32_t> m_epoch{};
+		std::atomic<std::uint32_t> m_sleeping{};
+
+		// declared last so the workers stop before anything they touch is destroyed
+		std::vector<std::jthread> m_threads{};
+	};
+}
@@ -1,10 +1,35 @@
 #include "engine.hpp"
+#include <charconv>
 #include <exception>
 #include <print>
+#include <span>
+#include <string_view>
 
-int main() {
+namespace {
+	// --headless [frames]: renders offscreen without a window, then prints the frame rate
+	[[nodiscard]] sve::Engine::CreateInfo parse_args(std::span<char const* const> args) {
+		auto ret = sve::Engine::CreateInfo{};
+		for (auto it = args.begin(); it != args.end(); ++it) {
+			if (std::string_view{ *it } != "--headless") {
+				std::println(stderr, "[sve] Ignoring unknown argument '{}'", *it);
+				continue;
+			}
+			ret.headless = true;
+			if (std::next(it) == args.end()) continue;
+			auto const next = std::string_view{ *std::next(it) };
+			auto frames = std::uint64_t{};
+			auto const [end, error] = std::from_chars(next.data(), next.data() + next.size(), frames);
+			if (error != std::errc{} || end != next.data() + next.size()) continue;
+			ret.headless_frames = frames;
+			++it;
+		}
+		return ret;
+	}
+}
+
+int main(int argc, char** argv) {
 	try {
-		sve::Engine{}.run();
+		sve::Engine{ parse_args(std::span{ argv, static_cast<std::size_t>(argc) }.subspan(1)) }.run();
 	}
 	catch (std::exception const& e) {
 		std::println(stderr, "PANIC: {}", e.what());
@@ -14,4 +39,4 @@ int main() {
 		std::println("PANIC!");
 		return EXIT_FAILURE;
 	}
-}
\ No newline at end of file
+}
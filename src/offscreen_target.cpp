@@ -0,0 +1,58 @@
+#include "offscreen_target.hpp"
+#include <print>
+#include <ranges>
+#include <stdexcept>
+
+namespace sve {
+	namespace {
+		constexpr auto subresource_range_v = [] {
+			auto ret = vk::ImageSubresourceRange{};
+			ret.setAspectMask(vk::ImageAspectFlagBits::eColor)
+				.setLayerCount(1)
+				.setLevelCount(1);
+			return ret;
+			}();
+	}
+
+	OffscreenTarget::OffscreenTarget(CreateInfo const& create_info)
+		: m_queue_family(create_info.queue_family), m_format(create_info.format) {
+		if (create_info.size.x <= 0 || create_info.size.y <= 0) {
+			throw std::runtime_error{ "Offscreen target size must be positive" };
+		}
+		m_extent = vk::Extent2D{ static_cast<std::uint32_t>(create_info.size.x), static_cast<std::uint32_t>(create_info.size.y) };
+
+		// transfer source so frames can be copied out, eg to compare against reference images
+		static constexpr auto usage_v = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+		auto const image_ci = vma::ImageCreateInfo{ .allocator = create_info.allocator, .queue_family = m_queue_family };
+		auto image_view_ci = vk::ImageViewCreateInfo{};
+		image_view_ci.setViewType(vk::ImageViewType::e2D)
+			.setFormat(m_format)
+			.setSubresourceRange(subresource_range_v);
+		for (auto [image, view] : std::views::zip(m_images, m_image_views)) {
+			image = vma::create_image(image_ci, usage_v, 1, m_format, m_extent);
+			if (!image.get().image) throw std::runtime_error{ "Failed to create offscreen image" };
+			image_view_ci.setImage(image.get().image);
+			view = create_info.device.createImageViewUnique(image_view_ci);
+		}
+
+		std::println(stderr, "[sve] Offscreen target [{}x{}] {} x{}", m_extent.width, m_extent.height, vk::to_string(m_format), m_images.size());
+	}
+
+	RenderTarget OffscreenTarget::acquire(std::size_t const frame_index) {
+		m_image_index = frame_index;
+		return RenderTarget{
+			.image = m_images.at(m_image_index).get().image,
+			.image_view = *m_image_views.at(m_image_index),
+			.extent = m_extent,
+		};
+	}
+
+	auto OffscreenTarget::base_barrier() const -> vk::ImageMemoryBarrier2 {
+		auto ret = vk::ImageMemoryBarrier2{};
+		ret.setImage(m_images.at(m_image_index).get().image)
+			.setSubresourceRange(subresource_range_v)
+			.setSrcQueueFamilyIndex(m_queue_family)
+			.setDstQueueFamilyIndex(m_queue_family);
+		return ret;
+	}
+}
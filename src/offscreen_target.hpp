@@ -0,0 +1,39 @@
+#pragma once
+#include "vma.hpp"
+#include "render_target.hpp"
+#include "resource_buffering.hpp"
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+namespace sve {
+	struct OffscreenTargetCreateInfo {
+		vk::Device device{};
+		vma::RawAllocator allocator{};
+		std::uint32_t queue_family{};
+		glm::ivec2 size{ 1280, 720 };
+		vk::Format format{ vk::Format::eR8G8B8A8Srgb };
+	};
+
+	// Stands in for the swapchain when rendering headless: one VMA image per frame slot, so a slot's
+	// image is free again once begin_frame() has waited for the slot. Nothing is presented, images
+	// stay in the attachment layout after the frame.
+	class OffscreenTarget {
+	public:
+		using CreateInfo = OffscreenTargetCreateInfo;
+
+		explicit OffscreenTarget(CreateInfo const& create_info);
+
+		[[nodiscard]] RenderTarget acquire(std::size_t frame_index);
+		[[nodiscard]] vk::ImageMemoryBarrier2 base_barrier() const;
+
+		[[nodiscard]] glm::ivec2 get_size() const { return { m_extent.width, m_extent.height }; }
+		[[nodiscard]] vk::Format get_format() const { return m_format; }
+	private:
+		std::uint32_t m_queue_family{};
+		vk::Extent2D m_extent{};
+		vk::Format m_format{};
+		Buffered<vma::Image> m_images{};
+		Buffered<vk::UniqueImageView> m_image_views{};
+		std::size_t m_image_index{};
+	};
+}
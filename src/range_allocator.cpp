@@ -0,0 +1,59 @@
+#include "range_allocator.hpp"
+#include <cassert>
+
+namespace sve {
+	RangeAllocator::RangeAllocator(std::uint32_t const capacity) : m_capacity(capacity) {
+		if (m_capacity > 0) insert_free(0, m_capacity);
+	}
+
+	std::uint32_t RangeAllocator::allocate(std::uint32_t const size) {
+		if (size == 0) return invalid_offset_v;
+		auto const it = m_by_size.lower_bound(size);
+		if (it == m_by_size.end()) return invalid_offset_v;
+
+		auto const [free_size, offset] = *it;
+		erase_free(m_by_offset.find(offset));
+		if (free_size > size) insert_free(offset + size, free_size - size);
+		m_used += size;
+		return offset;
+	}
+
+	void RangeAllocator::free(std::uint32_t offset, std::uint32_t size) {
+		if (size == 0) return;
+		assert(offset + size <= m_capacity && m_used >= size);
+		m_used -= size;
+
+		auto next = m_by_offset.lower_bound(offset);
+		assert(next == m_by_offset.end() || next->first >= offset + size);
+		if (next != m_by_offset.end() && next->first == offset + size) {
+			size += next->second;
+			next = std::next(next);
+			erase_free(std::prev(next));
+		}
+		if (next != m_by_offset.begin()) {
+			auto const prev = std::prev(next);
+			assert(prev->first + prev->second <= offset);
+			if (prev->first + prev->second == offset) {
+				offset = prev->first;
+				size += prev->second;
+				erase_free(prev);
+			}
+		}
+		insert_free(offset, size);
+	}
+
+	void RangeAllocator::insert_free(std::uint32_t const offset, std::uint32_t const size) {
+		m_by_offset.emplace(offset, size);
+		m_by_size.emplace(size, offset);
+	}
+
+	void RangeAllocator::erase_free(std::map<std::uint32_t, std::uint32_t>::iterator const it) {
+		auto [first, last] = m_by_size.equal_range(it->second);
+		for (; first != last; ++first) {
+			if (first->second != it->first) continue;
+			m_by_size.erase(first);
+			break;
+		}
+		m_by_offset.erase(it);
+	}
+}
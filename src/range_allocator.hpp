@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <map>
+
+namespace sve {
+	// Best fit suballocator over [0, capacity) in abstract units (elements, bytes...).
+	// Free ranges are kept both by offset, to coalesce neighbours, and by size, to find the best fit.
+	class RangeAllocator {
+	public:
+		static constexpr auto invalid_offset_v = std::numeric_limits<std::uint32_t>::max();
+
+		explicit RangeAllocator(std::uint32_t capacity = 0);
+
+		// invalid_offset_v when no free range is large enough
+		[[nodiscard]] std::uint32_t allocate(std::uint32_t size);
+		void free(std::uint32_t offset, std::uint32_t size);
+
+		[[nodiscard]] std::uint32_t get_capacity() const { return m_capacity; }
+		[[nodiscard]] std::uint32_t get_used() const { return m_used; }
+		[[nodiscard]] std::size_t get_free_range_count() const { return m_by_offset.size(); }
+		[[nodiscard]] std::uint32_t get_largest_free() const { return m_by_size.empty() ? 0 : std::prev(m_by_size.end())->first; }
+
+	private:
+		void insert_free(std::uint32_t offset, std::uint32_t size);
+		void erase_free(std::map<std::uint32_t, std::uint32_t>::iterator it);
+
+		// offset -> size
+		std::map<std::uint32_t, std::uint32_t> m_by_offset{};
+		// size -> offset
+		std::multimap<std::uint32_t, std::uint32_t> m_by_size{};
+		std::uint32_t m_capacity{};
+		std::uint32_t m_used{};
+	};
+}
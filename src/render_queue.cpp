@@ -0,0 +1,121 @@
+#include "render_queue.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory>
+#include <utility>
+
+namespace sve {
+	namespace {
+		constexpr std::uint32_t depth_bits_v{ 23 };
+		constexpr std::uint32_t shader_bits_v{ 10 };
+		constexpr std::uint32_t texture_bits_v{ 14 };
+		constexpr std::uint32_t mesh_bits_v{ 12 };
+
+		[[nodiscard]] constexpr std::uint64_t mask(std::uint32_t const value, std::uint32_t const bits) {
+			return static_cast<std::uint64_t>(value) & ((std::uint64_t{ 1 } << bits) - 1);
+		}
+
+		[[nodiscard]] std::uint32_t quantize_depth(float const depth) {
+			static constexpr auto max_v = static_cast<float>((1u << depth_bits_v) - 1);
+			return static_cast<std::uint32_t>(std::clamp(depth, 0.0f, 1.0f) * max_v);
+		}
+
+		// assigning would keep the old resource, polymorphic allocators don't propagate
+		template <typename Type>
+		void rebind(std::pmr::vector<Type>& vector, std::pmr::memory_resource& resource) {
+			std::destroy_at(&vector);
+			std::construct_at(&vector, &resource);
+		}
+	}
+
+	std::uint64_t encode_draw_key(DrawKeyFields const& fields) {
+		auto const state = (mask(fields.shader, shader_bits_v) << (texture_bits_v + mesh_bits_v))
+			| (mask(fields.texture, texture_bits_v) << mesh_bits_v)
+			| mask(fields.mesh, mesh_bits_v);
+		auto const depth = quantize_depth(fields.depth);
+
+		assert(fields.layer < SubmitInfo::layer_count_v);
+		auto ret = mask(fields.layer, 4) << 60;
+		if (fields.translucent) {
+			ret |= std::uint64_t{ 1 } << 59;
+			ret |= mask(~depth, depth_bits_v) << (shader_bits_v + texture_bits_v + mesh_bits_v);
+			ret |= state;
+		}
+		else {
+			ret |= state << depth_bits_v;
+			ret |= depth;
+		}
+		return ret;
+	}
+
+	void radix_sort(std::span<RenderItem> items, std::span<RenderItem> scratch) {
+		static constexpr auto passes_v = sizeof(std::uint64_t);
+		static constexpr auto buckets_v = 256uz;
+
+		if (items.size() < 2) return;
+		assert(scratch.size() >= items.size());
+
+		auto histograms = std::array<std::array<std::uint32_t, buckets_v>, passes_v>{};
+		for (auto const& item : items) {
+			for (auto pass = 0uz; pass < passes_v; ++pass) {
+				++histograms[pass][(item.key >> (pass * 8)) & 0xff];
+			}
+		}
+
+		auto src = items;
+		auto dst = scratch.first(items.size());
+		for (auto pass = 0uz; pass < passes_v; ++pass) {
+			auto const shift = pass * 8;
+			auto& histogram = histograms[pass];
+			// every key shares this byte, the pass would be an identity permutation
+			if (histogram[(src.front().key >> shift) & 0xff] == items.size()) continue;
+
+			auto offset = std::uint32_t{};
+			for (auto& count : histogram) {
+				offset += std::exchange(count, offset);
+			}
+			for (auto const& item : src) {
+				dst[histogram[(item.key >> shift) & 0xff]++] = item;
+			}
+			std::swap(src, dst);
+		}
+
+		if (src.data() != items.data()) {
+			std::ranges::copy(src, items.begin());
+		}
+	}
+
+	void RenderQueue::begin_frame(std::pmr::memory_resource& resource, std::size_t const capacity) {
+		rebind(m_items, resource);
+		rebind(m_scratch, resource);
+		rebind(m_payloads, resource);
+		m_items.reserve(capacity);
+		m_payloads.reserve(capacity);
+	}
+
+	void RenderQueue::push(Object& object, SubmitInfo const& info) {
+		// handle indices are small and stable while resources live, indices wider than their
+		// key field alias, which only costs grouping: batches compare the full handles
+		auto const fields = DrawKeyFields{
+			.layer = info.layer,
+			.translucent = info.translucent,
+			.shader = object.material.shader.index,
+			.texture = object.material.texture.index,
+			.mesh = object.mesh.index,
+			.depth = info.depth
+		};
+		m_items.push_back(RenderItem{ .key = encode_draw_key(fields), .payload = static_cast<std::uint32_t>(m_payloads.size()) });
+		m_payloads.push_back(&object);
+	}
+
+	void RenderQueue::sort() {
+		m_scratch.resize(m_items.size());
+		radix_sort(m_items, m_scratch);
+	}
+
+	void RenderQueue::clear() {
+		m_items.clear();
+		m_payloads.clear();
+	}
+}
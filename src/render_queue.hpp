@@ -0,0 +1,63 @@
+#pragma once
+#include "utils/object.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace sve {
+	// per-submission sort parameters, depth is normalized to [0, 1] with 0 nearest
+	struct SubmitInfo {
+		static constexpr std::uint8_t layer_count_v{ 16 };
+
+		// in [0, layer_count_v), lower layers draw first
+		std::uint8_t layer{};
+		float depth{};
+		// drawn back to front after the opaque draws of its layer instead of grouped by state,
+		// set it for draws that blend with what is behind them
+		bool translucent{};
+	};
+
+	struct DrawKeyFields {
+		std::uint8_t layer{};
+		bool translucent{};
+		std::uint32_t shader{};
+		std::uint32_t texture{};
+		std::uint32_t mesh{};
+		float depth{};
+	};
+
+	// 64-bit sort key, from most to least significant:
+	// opaque:      layer(4) | 0 | shader(10) | texture(14) | mesh(12) | depth(23)
+	// translucent: layer(4) | 1 | ~depth(23) | shader(10) | texture(14) | mesh(12)
+	// opaque draws are grouped by state and go front to back, translucent draws go back to front
+	[[nodiscard]] std::uint64_t encode_draw_key(DrawKeyFields const& fields);
+
+	struct RenderItem {
+		std::uint64_t key{};
+		std::uint32_t payload{};
+	};
+
+	// stable LSD radix sort on RenderItem::key, scratch must be at least as large as items
+	void radix_sort(std::span<RenderItem> items, std::span<RenderItem> scratch);
+
+	class RenderQueue {
+	public:
+		// drops the previous frame's storage and takes it from resource until the next call,
+		// capacity is the expected number of pushes
+		void begin_frame(std::pmr::memory_resource& resource, std::size_t capacity);
+		void push(Object& object, SubmitInfo const& info);
+		void sort();
+		void clear();
+
+		[[nodiscard]] std::span<RenderItem const> get_items() const { return m_items; }
+		[[nodiscard]] Object& get_object(RenderItem const& item) const { return *m_payloads.at(item.payload); }
+		[[nodiscard]] std::size_t size() const { return m_items.size(); }
+		[[nodiscard]] bool empty() const { return m_items.empty(); }
+
+	private:
+		std::pmr::vector<RenderItem> m_items{};
+		std::pmr::vector<RenderItem> m_scratch{};
+		std::pmr::vector<Object*> m_payloads{};
+	};
+}
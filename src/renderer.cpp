@@ -1,13 +1,14 @@
 #include "renderer.hpp"
+#include "cpu_profiler.hpp"
 #include "window.hpp"
 #include "utils/vertex.hpp"
+#include <algorithm>
 #include <ranges>
 #include <chrono>
 #include <bit>
-#include <glm/ext/matrix_clip_space.hpp>
-
-constexpr auto MAX_OBJECTS = 16;;
-constexpr auto MAX_TEXTURES = 16;;
+#include <cassert>
+#include <cfloat>
+#include <cmath>
 
 using namespace std::chrono_literals;
 
@@ -19,30 +20,103 @@ namespace sve {
 	}
 
 	std::vector<vk::DescriptorSet> Renderer::allocate_sets() const {
+		// set 1 is the bindless texture array, shared by every frame
+		auto const per_frame_layouts = std::array{ *m_set_layouts[0], *m_set_layouts[1] };
 		auto allocate_info = vk::DescriptorSetAllocateInfo{};
 		allocate_info.setDescriptorPool(*m_descriptor_pool)
-			.setSetLayouts(m_set_layout_views);
-		return m_device.allocateDescriptorSets(allocate_info);
+			.setSetLayouts(per_frame_layouts);
+		auto const sets = m_device.allocateDescriptorSets(allocate_info);
+		return { sets[0], m_texture_registry->get_set(), sets[1] };
 	}
 
 
 	Renderer::Renderer(CreateInfo& ci) 
 	: m_gpu(ci.gpu), m_device(ci.device), m_window(ci.window), m_instance(ci.instance), m_queue(ci.queue),
-	  m_format(ci.format), m_swapchain(ci.swapchain), m_allocator(*ci.allocator) {
-
+	  m_format(ci.format), m_swapchain(ci.swapchain), m_allocator(*ci.allocator), m_jobs(ci.jobs) {
+
+
+		if (!m_swapchain) {
+			auto const offscreen_ci = OffscreenTarget::CreateInfo{
+				.device = m_device,
+				.allocator = m_allocator,
+				.queue_family = m_gpu.queue_family,
+				.size = ci.headless_size
+			};
+			m_offscreen.emplace(offscreen_ci);
+			m_format = m_offscreen->get_format();
+		}
 
-		create_render_sync();
-		create_imgui();
+		create_render_sync(ci.frames_in_flight);
+		// restored when low latency is turned off, which it may be from the start with a single frame
+		m_throughput_frames_in_flight = ci.frames_in_flight > 1 ? ci.frames_in_flight : static_cast<std::uint32_t>(default_frames_in_flight_v);
+		// the inspector draws into the window, headless frames have none
+		if (m_swapchain) create_imgui();
+		auto const upload_queue_ci = UploadQueue::CreateInfo{
+			.device = m_device,
+			.allocator = m_allocator,
+			.graphics_queue = m_queue,
+			.graphics_family = m_gpu.queue_family,
+			.transfer_queue = ci.transfer_queue,
+			.transfer_family = m_gpu.transfer_queue_family
+		};
+		m_uploads.emplace(upload_queue_ci);
+		auto const defragmenter_ci = Defragmenter::CreateInfo{
+			.device = m_device,
+			.allocator = m_allocator.handle,
+			.timeline = &*m_frame_timeline
+		};
+		m_defragmenter.emplace(defragmenter_ci);
+		auto const geometry_arena_ci = GeometryArena::CreateInfo{
+			.allocator = m_allocator,
+			.queue_family = m_gpu.queue_family,
+			.uploads = &*m_uploads,
+			.defragmenter = &*m_defragmenter
+		};
+		m_geometry.emplace(geometry_arena_ci);
+		// the device may hold fewer bindless textures than the registry would like
+		m_texture_registry.emplace(m_device, std::min(TextureRegistry::capacity_v, m_gpu.max_bindless_textures));
 		create_descriptor_pool();
-		create_cmd_block_pool();
 		create_pipeline_layout();
 		create_descriptor_sets();
 
 		m_view_ubo.emplace(m_allocator, m_gpu.queue_family, vk::BufferUsageFlagBits::eUniformBuffer);
-		m_instance_ssbo.emplace(m_allocator, m_gpu.queue_family, vk::BufferUsageFlagBits::eStorageBuffer);
+		auto const instance_ring_ci = RingBuffer::CreateInfo{
+			.allocator = m_allocator,
+			.queue_family = m_gpu.queue_family,
+			.usage = vk::BufferUsageFlagBits::eStorageBuffer,
+			.alignment = m_gpu.properties.limits.minStorageBufferOffsetAlignment
+		};
+		m_instance_ring.emplace(instance_ring_ci);
+
+		auto const recorder_ci = CommandRecorder::CreateInfo{
+			.device = m_device,
+			.queue_family = m_gpu.queue_family,
+			.jobs = m_jobs
+		};
+		m_recorder.emplace(recorder_ci);
+
+		if (!ci.cull_spirv.empty()) {
+			auto const gpu_scene_ci = GpuScene::CreateInfo{
+				.device = m_device,
+				.allocator = m_allocator,
+				.queue_family = m_gpu.queue_family,
+				.resources = &m_resources,
+				.cull_spirv = ci.cull_spirv,
+				.instance_set_layout = *m_set_layouts[1]
+			};
+			m_gpu_scene.emplace(gpu_scene_ci);
+		}
+
+		vma::set_evict_callback(m_allocator, [this] { return evict(); });
+	}
+
+	Renderer::~Renderer() {
+		vma::set_evict_callback(m_allocator, {});
+		m_frame_timeline->wait_idle();
+		m_deletion_queue.flush();
 	}
 
-	void Renderer::create_render_sync() {
+	void Renderer::create_render_sync(std::uint32_t const frames_in_flight) {
 		auto command_pool_ci = vk::CommandPoolCreateInfo{};
 		command_pool_ci.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
 			.setQueueFamilyIndex(m_gpu.queue_family);
@@ -55,12 +129,13 @@ namespace sve {
 		auto const command_buffers = m_device.allocateCommandBuffers(command_buffer_ai);
 		assert(command_buffers.size() == m_render_sync.size());
 
-		static constexpr auto fence_create_info_v = vk::FenceCreateInfo{ vk::FenceCreateFlagBits::eSignaled };
 		for (auto [sync, command_buffer] : std::views::zip(m_render_sync, command_buffers)) {
 			sync.command_buffer = command_buffer;
 			sync.draw = m_device.createSemaphoreUnique({});
-			sync.drawn = m_device.createFenceUnique(fence_create_info_v);
 		}
+
+		m_frame_timeline.emplace(FrameTimeline::CreateInfo{ .device = m_device, .frames_in_flight = frames_in_flight });
+		m_profiler.emplace(GpuProfiler::CreateInfo{ .device = m_device, .physical_device = m_gpu.device, .queue_family = m_gpu.queue_family });
 	}
 
 	void Renderer::create_imgui() {
@@ -81,7 +156,7 @@ namespace sve {
 	void Renderer::create_descriptor_pool() {
 		static constexpr auto pool_sizes_v = std::array{
 			vk::DescriptorPoolSize{vk::DescriptorType::eUniformBuffer, 8},
-			vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler,8},
+			vk::DescriptorPoolSize{vk::DescriptorType::eStorageBufferDynamic, 8},
 		};
 		auto pool_ci = vk::DescriptorPoolCreateInfo{};
 		pool_ci.setPoolSizes(pool_sizes_v).setMaxSets(16);
@@ -92,41 +167,25 @@ namespace sve {
 		static constexpr auto set_0_bindings_v = std::array{
 			layout_binding(0, vk::DescriptorType::eUniformBuffer)
 		};
-		static constexpr auto set_1_bindings_v = std::array{
-			vk::DescriptorSetLayoutBinding{0, vk::DescriptorType::eCombinedImageSampler, MAX_TEXTURES, vk::ShaderStageFlagBits::eFragment},
-		};
 		static constexpr auto set_2_bindings_v = std::array{
-			layout_binding(0, vk::DescriptorType::eStorageBuffer),
+			layout_binding(0, vk::DescriptorType::eStorageBufferDynamic),
 		};
 
-		auto set_layout_cis = std::array<vk::DescriptorSetLayoutCreateInfo, 3>{};
+		auto set_layout_cis = std::array<vk::DescriptorSetLayoutCreateInfo, 2>{};
 		set_layout_cis[0].setBindings(set_0_bindings_v);
-		set_layout_cis[1].setBindings(set_1_bindings_v);
-		set_layout_cis[2].setBindings(set_2_bindings_v);
+		set_layout_cis[1].setBindings(set_2_bindings_v);
 
 		for (auto const& set_layout_ci : set_layout_cis) {
 			m_set_layouts.push_back(m_device.createDescriptorSetLayoutUnique(set_layout_ci));
-			m_set_layout_views.push_back(*m_set_layouts.back());
 		}
-
-		vk::PushConstantRange pc{};
-		pc.stageFlags = vk::ShaderStageFlagBits::eFragment;
-		pc.offset = 0;
-		pc.size = sizeof(uint32_t);
+		m_set_layout_views = { *m_set_layouts[0], m_texture_registry->get_set_layout(), *m_set_layouts[1] };
 
 		auto pipeline_layout_ci = vk::PipelineLayoutCreateInfo{};
 		pipeline_layout_ci.setSetLayouts(m_set_layout_views);
-		pipeline_layout_ci.setPushConstantRanges(pc);
+		pipeline_layout_ci.setPushConstantRanges(push_constant_ranges_v);
 		m_pipeline_layout = m_device.createPipelineLayoutUnique(pipeline_layout_ci);
 	}
 
-	void Renderer::create_cmd_block_pool() {
-		auto command_pool_ci = vk::CommandPoolCreateInfo{};
-		command_pool_ci.setQueueFamilyIndex(m_gpu.queue_family)
-			.setFlags(vk::CommandPoolCreateFlagBits::eTransient);
-		m_cmd_block_pool = m_device.createCommandPoolUnique(command_pool_ci);
-	}
-
 	void Renderer::create_descriptor_sets() {
 		for (auto& descriptor_sets : m_descriptor_sets) {
 			descriptor_sets = allocate_sets();
@@ -134,53 +193,65 @@ namespace sve {
 	}
 
 	bool Renderer::acquire_render_target() {
-		m_framebuffer_size = glfw::framebuffer_size(m_window);
+		m_framebuffer_size = m_swapchain ? glfw::framebuffer_size(m_window) : m_offscreen->get_size();
 		// skip if minimized
 		if (m_framebuffer_size.x <= 0 || m_framebuffer_size.y <= 0) return false;
 
-		auto& render_sync = m_render_sync.at(m_frame_index);
-
-		static constexpr auto fence_timeout_v = static_cast<std::uint64_t>(std::chrono::nanoseconds{ 3s }.count());
-		auto result = m_device.waitForFences(*render_sync.drawn, vk::True, fence_timeout_v);
-		if (result != vk::Result::eSuccess)
-		{
-			throw std::runtime_error{ "Failed to wait for Render Fence" };
+		// waits for the slot's previous frame, which also frees its acquire semaphore
+		m_frame_index = m_frame_timeline->begin_frame();
+		auto const completed_value = m_frame_timeline->get_completed_value();
+		m_deletion_queue.collect(completed_value);
+		m_geometry->collect(completed_value);
+		m_defragmenter->collect();
+		if (!m_swapchain) {
+			m_render_target = m_offscreen->acquire(m_frame_index);
+			return true;
 		}
 
-		m_render_target = m_swapchain.aquire_next_image(*render_sync.draw);
+		m_swapchain->collect_retired(completed_value);
+		auto& render_sync = m_render_sync.at(m_frame_index);
+		m_render_target = m_swapchain->aquire_next_image(*render_sync.draw);
 		if (!m_render_target)
 		{
-			m_swapchain.recreate(m_framebuffer_size);
+			recreate_swapchain();
 			return false;
 		}
 
-		m_device.resetFences(*render_sync.drawn);
 		m_imgui->new_frame();
 
 		return true;
 	}
 
 	void Renderer::update_instance_ssbo() {
-		std::vector<glm::mat4> models;
-		models.reserve(m_objects_to_draw.size());
-
-		for (auto& object : m_objects_to_draw) {
-			models.push_back(object->transform.model_matrix());
-		}
+		m_instance_ring->begin_frame(m_frame_index);
+		auto const write = [this]<typename Type>() {
+			auto const instances = m_instance_ring->allocate<Type>(m_batcher.get_instance_count());
+			m_batcher.write_instances(instances.data, *m_jobs);
+			m_first_instance = instances.first_element;
+			};
+		if (m_instance_format == InstanceFormat::Affine) write.template operator()<AffineInstance>();
+		else write.template operator()<glm::mat4>();
+	}
 
-		m_instance_ssbo->write_at(m_frame_index, std::as_bytes(std::span{ models }));
+	Rect Renderer::get_view_rect() const {
+		// inverse of update_view: the view matrix scales, then translates, then rotates
+		auto const half_size = 0.5f * glm::vec2{ m_framebuffer_size };
+		auto const radians = glm::radians(m_view_transform.rotation);
+		auto const s = std::abs(std::sin(radians));
+		auto const c = std::abs(std::cos(radians));
+		auto const extent = glm::vec2{ c * half_size.x + s * half_size.y, s * half_size.x + c * half_size.y };
+		auto const a = (m_view_transform.position - extent) / m_view_transform.scale;
+		auto const b = (m_view_transform.position + extent) / m_view_transform.scale;
+		return Rect{ .min = glm::min(a, b), .max = glm::max(a, b) };
 	}
 
 	void Renderer::update_view() {
-		auto const half_size = 0.5f * glm::vec2{ m_framebuffer_size };
-		auto const mat_projection = glm::ortho(-half_size.x, half_size.x, -half_size.y, half_size.y);
-		auto const mat_view = m_view_transform.view_matrix();
-		auto const mat_vp = mat_projection * mat_view;
+		auto const mat_vp = view_projection_matrix(m_view_transform, glm::vec2{ m_framebuffer_size });
 		auto const bytes = std::bit_cast<std::array<std::byte, sizeof(mat_vp)>>(mat_vp);
 		m_view_ubo->write_at(m_frame_index, bytes);
 	}
 
-	void Renderer::bind_descriptor_sets(vk::CommandBuffer const command_buffer) const {
+	void Renderer::write_descriptor_sets() {
 		auto writes = std::array<vk::WriteDescriptorSet, 2>{};
 		auto const& descriptor_sets = m_descriptor_sets.at(m_frame_index);
 
@@ -195,36 +266,28 @@ namespace sve {
 			.setDstBinding(0);
 		writes[0] = write;
 
-		auto const set2 = descriptor_sets[2];
-		auto ssbo_info = m_instance_ssbo->descripter_info_at(m_frame_index);
-		write.setBufferInfo(ssbo_info)
-			.setDescriptorType(vk::DescriptorType::eStorageBuffer)
-			.setDescriptorCount(1)
-			.setDstSet(set2)
-			.setDstBinding(0);
-		writes[1] = write;
-
-		m_device.updateDescriptorSets(writes, {});
-
-		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_pipeline_layout, 0, descriptor_sets, {});
-	}
-
-	void Renderer::update_textures_array(std::span<Texture*> textures) {
-		std::vector<vk::DescriptorImageInfo> infos;
-		infos.reserve(textures.size());
-
-		for (auto* tex : textures) {
-			infos.push_back(tex->descriptor_info());
+		// the instance ring only needs rewriting when it was replaced by a bigger buffer
+		auto write_count = std::uint32_t{ 1 };
+		auto& ring_generation = m_instance_ring_generations.at(m_frame_index);
+		auto const ssbo_info = m_instance_ring->get_descriptor_info();
+		if (ring_generation != m_instance_ring->get_generation()) {
+			auto const set2 = descriptor_sets[2];
+			write.setBufferInfo(ssbo_info)
+				.setDescriptorType(vk::DescriptorType::eStorageBufferDynamic)
+				.setDescriptorCount(1)
+				.setDstSet(set2)
+				.setDstBinding(0);
+			writes[write_count++] = write;
+			ring_generation = m_instance_ring->get_generation();
 		}
 
-		vk::WriteDescriptorSet write{};
-		write.setDstSet(m_descriptor_sets[m_frame_index][1])
-			.setDstBinding(0)
-			.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-			.setImageInfo(infos)
-			.setDescriptorCount(static_cast<uint32_t>(infos.size()));
+		m_device.updateDescriptorSets(vk::ArrayProxy<vk::WriteDescriptorSet const>{ write_count, writes.data() }, {});
+	}
 
-		m_device.updateDescriptorSets(write, {});
+	void Renderer::bind_descriptor_sets(vk::CommandBuffer const command_buffer) const {
+		auto const& descriptor_sets = m_descriptor_sets.at(m_frame_index);
+		auto const dynamic_offset = m_instance_ring->get_dynamic_offset();
+		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_pipeline_layout, 0, descriptor_sets, dynamic_offset);
 	}
 
 	void Renderer::inspect() {
@@ -242,11 +305,62 @@ namespace sve {
 			}*/
 
 			static auto const inspect_transform = [](Transform& out) {
-				ImGui::DragFloat2("Position", &out.position.x);
-				ImGui::DragFloat("Rotation", &out.rotation);
-				ImGui::DragFloat2("Scale", &out.scale.x, 0.1f);
+				auto changed = ImGui::DragFloat2("Position", &out.position.x);
+				changed |= ImGui::DragFloat("Rotation", &out.rotation);
+				changed |= ImGui::DragFloat2("Scale", &out.scale.x, 0.1f);
+				return changed;
 				};
 
+			ImGui::Separator();
+			ImGui::Text("Objects: %u (%u culled)", m_stats.objects, m_stats.culled);
+			ImGui::Text("Batches: %u", m_stats.batches);
+			auto compact_instances = m_instance_format == InstanceFormat::Affine;
+			if (ImGui::Checkbox("Compact instances", &compact_instances)) {
+				m_instance_format = compact_instances ? InstanceFormat::Affine : InstanceFormat::Matrix;
+			}
+			ImGui::Text("Textures: %u / %u", m_texture_registry->get_count(), m_texture_registry->get_capacity());
+			ImGui::Text("Uploads: %zu pending, %zu in flight, %.1f / %.1f MiB staging", m_uploads->get_pending_count(), m_uploads->get_in_flight_count(),
+				static_cast<double>(m_uploads->get_staging_used()) / (1024.0 * 1024.0), static_cast<double>(m_uploads->get_staging_size()) / (1024.0 * 1024.0));
+			auto const& vertex_ranges = m_geometry->get_vertex_ranges();
+			auto const& index_ranges = m_geometry->get_index_ranges();
+			ImGui::Text("Geometry: %u / %u vertices, %u / %u indices", vertex_ranges.get_used(), vertex_ranges.get_capacity(),
+				index_ranges.get_used(), index_ranges.get_capacity());
+			ImGui::Text("Frame arena: %.1f KiB peak of %.1f KiB (%llu upstream allocations)",
+				static_cast<double>(m_frame_arena.get_peak()) / 1024.0, static_cast<double>(m_frame_arena.get_capacity()) / 1024.0,
+				static_cast<unsigned long long>(m_frame_arena.get_upstream_allocations()));
+			ImGui::Text("Pending deletions: %zu", get_pending_deletions());
+			ImGui::Text("State commands: %u (%u skipped)", m_stats.state_commands.emitted, m_stats.state_commands.skipped);
+			if (m_gpu_scene) ImGui::Text("GPU objects: %u (%zu segments)", m_stats.gpu_objects, m_gpu_scene->get_segments().size());
+			else ImGui::Text("GPU culling: unavailable");
+			ImGui::Text("Record: %.3f ms (%u secondaries)", m_stats.record_ms, m_stats.record_chunks);
+			if (ImGui::BeginCombo("Present mode", vk::to_string(get_present_mode()).c_str())) {
+				for (auto const mode : m_swapchain->get_present_modes()) {
+					if (ImGui::Selectable(vk::to_string(mode).c_str(), mode == get_present_mode())) set_present_mode(mode);
+				}
+				ImGui::EndCombo();
+			}
+			auto low_latency = is_low_latency();
+			if (ImGui::Checkbox("Low latency", &low_latency)) set_low_latency(low_latency);
+			ImGui::Text(m_swapchain->has_present_wait() ? "Input to present: %.2f ms" : "Input to GPU done: %.2f ms", m_stats.latency_ms);
+			auto frames_in_flight = static_cast<int>(get_frames_in_flight());
+			if (ImGui::SliderInt("Frames in flight", &frames_in_flight, 1, static_cast<int>(resource_buffering_v))) {
+				set_frames_in_flight(static_cast<std::uint32_t>(frames_in_flight));
+			}
+			auto record_threads = static_cast<int>(m_recorder->get_active_threads());
+			if (ImGui::SliderInt("Record threads", &record_threads, 1, static_cast<int>(m_recorder->get_thread_count()))) {
+				m_recorder->set_active_threads(static_cast<std::uint32_t>(record_threads));
+			}
+
+			ImGui::Separator();
+			if (ImGui::TreeNode("Timings")) {
+				inspect_timings();
+				ImGui::TreePop();
+			}
+			if (ImGui::TreeNode("Memory")) {
+				inspect_memory();
+				ImGui::TreePop();
+			}
+
 			ImGui::Separator();
 			if (ImGui::TreeNode("View")) {
 				inspect_transform(m_view_transform);
@@ -255,10 +369,13 @@ namespace sve {
 
 			ImGui::Separator();
 			if (ImGui::TreeNode("Instances")) {
-				for (size_t i = 0; i < m_objects_to_draw.size(); i++) {
-					auto const label = std::to_string(i);
+				for (auto const& item : m_render_queue.get_items()) {
+					auto const label = std::to_string(item.payload);
 					if (ImGui::TreeNode(label.c_str())) {
-						inspect_transform(m_objects_to_draw.at(i)->transform);
+						auto& object = m_render_queue.get_object(item);
+						if (inspect_transform(object.transform) && object.proxy != SpatialGrid::invalid_proxy_v) {
+							update(object);
+						}
 						ImGui::TreePop();
 					}
 				}
@@ -268,18 +385,167 @@ namespace sve {
 		ImGui::End();
 	}
 
+	void Renderer::inspect_timings() {
+		ImGui::Text("CPU record: %.3f ms", m_stats.record_ms);
+		inspect_cpu_zones();
+		if (!m_profiler->is_enabled()) {
+			ImGui::Text("GPU profiler: unavailable");
+			return;
+		}
+		// results lag by the frames in flight
+		ImGui::Text("GPU frame: %.3f ms", m_profiler->get_frame_ms());
+		auto const history = m_profiler->get_history();
+		ImGui::PlotLines("##gpu_history", history.data(), static_cast<int>(history.size()), static_cast<int>(m_profiler->get_history_offset()),
+			nullptr, 0.0f, FLT_MAX, ImVec2{ 0.0f, 40.0f });
+		inspect_gpu_timeline();
+		for (auto const& result : m_profiler->get_results()) {
+			ImGui::Indent(static_cast<float>(result.depth + 1) * 8.0f);
+			ImGui::Text("%.*s: %.3f ms", static_cast<int>(result.name.size()), result.name.data(), result.ms);
+			ImGui::Unindent(static_cast<float>(result.depth + 1) * 8.0f);
+		}
+	}
+
+	void Renderer::inspect_gpu_timeline() {
+		static constexpr auto row_height_v = 18.0f;
+		auto const results = m_profiler->get_results();
+		auto const frame_ms = m_profiler->get_frame_ms();
+		if (results.empty() || frame_ms <= 0.0f) return;
+
+		// one row per nesting level, scopes are bars on the frame's time axis
+		auto rows = 0u;
+		for (auto const& result : results) rows = std::max(rows, result.depth + 1);
+		auto const width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+		auto const origin = ImGui::GetCursorScreenPos();
+		auto const scale = width / frame_ms;
+		auto* draw_list = ImGui::GetWindowDrawList();
+		for (auto const [index, result] : std::views::enumerate(results)) {
+			auto const min = ImVec2{ origin.x + result.begin_ms * scale, origin.y + static_cast<float>(result.depth) * row_height_v };
+			auto const max = ImVec2{ min.x + std::max(result.ms * scale, 1.0f), min.y + row_height_v - 1.0f };
+			auto const hue = std::fmod(static_cast<float>(index) * 0.17f, 1.0f);
+			draw_list->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.7f));
+			draw_list->PushClipRect(min, max, true);
+			draw_list->AddText(ImVec2{ min.x + 2.0f, min.y + 1.0f }, IM_COL32_WHITE, result.name.data(), result.name.data() + result.name.size());
+			draw_list->PopClipRect();
+			if (ImGui::IsMouseHoveringRect(min, max)) {
+				ImGui::SetTooltip("%.*s: %.3f ms at %.3f ms", static_cast<int>(result.name.size()), result.name.data(), result.ms, result.begin_ms);
+			}
+		}
+		ImGui::Dummy(ImVec2{ width, static_cast<float>(rows) * row_height_v });
+	}
+
+	void Renderer::inspect_cpu_zones() {
+		ImGui::Text("CPU frame: %.3f ms", cpu_profiler::get_frame_ms());
+		for (auto const& zone : cpu_profiler::get_frame_summary()) {
+			ImGui::Indent(8.0f);
+			ImGui::Text("%s: %.3f ms (%u)", zone.name, zone.ms, zone.calls);
+			ImGui::Unindent(8.0f);
+		}
+		// the rings hold the last few thousand zones of every thread
+		if (ImGui::Button("Export CPU trace")) cpu_profiler::export_chrome_trace("sve_trace.json");
+	}
+
+	void Renderer::inspect_memory() {
+		static constexpr auto to_mib = [](vk::DeviceSize const bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+		auto const stats = get_memory_stats();
+		for (auto i = 0u; i < stats.heap_count; ++i) {
+			auto const& heap = stats.heaps[i];
+			ImGui::Text("Heap %u%s: %.1f / %.1f MiB, %.1f MiB unused in blocks", i, heap.device_local ? " (device)" : "",
+				to_mib(heap.usage), to_mib(heap.budget), to_mib(heap.block_bytes - heap.allocation_bytes));
+			ImGui::ProgressBar(heap.budget > 0 ? static_cast<float>(heap.usage) / static_cast<float>(heap.budget) : 0.0f);
+		}
+		for (auto i = 0uz; i < vma::memory_category_count_v; ++i) {
+			auto const& category = stats.categories[i];
+			auto const name = vma::to_string(static_cast<vma::MemoryCategory>(i));
+			ImGui::Text("%.*s: %u allocations, %.2f MiB", static_cast<int>(name.size()), name.data(), category.allocations, to_mib(category.bytes));
+		}
+		ImGui::Text("Evicted for: %u, over budget: %u", stats.evicted_allocations, stats.over_budget_allocations);
+
+		auto defragment = m_defragmenter->is_enabled();
+		if (ImGui::Checkbox("Defragment", &defragment)) m_defragmenter->set_enabled(defragment);
+		ImGui::Text("Defragmentation: %s, %u passes, %u moves (%.2f MiB)", m_defragmenter->is_running() ? "running" : "idle",
+			m_defragmenter->get_pass_count(), m_defragmenter->get_moved_count(), to_mib(m_defragmenter->get_moved_bytes()));
+	}
+
+	std::size_t Renderer::get_pending_deletions() const {
+		return m_deletion_queue.size() + m_geometry->get_pending_releases() + (m_swapchain ? m_swapchain->get_retired_count() : 0);
+	}
+
+	bool Renderer::evict() {
+		// only what submitted frames released, the frame being recorded may still use the rest
+		auto const pending = get_pending_deletions();
+		auto const submitted_value = m_frame_timeline->get_submitted_value();
+		m_frame_timeline->wait(submitted_value);
+		m_deletion_queue.collect(submitted_value);
+		m_geometry->collect(submitted_value);
+		if (m_swapchain) m_swapchain->collect_retired(submitted_value);
+		// a finished defragmentation pass frees the places it moved from
+		auto const in_pass = m_defragmenter->is_in_pass();
+		m_defragmenter->collect();
+		return get_pending_deletions() < pending || in_pass != m_defragmenter->is_in_pass();
+	}
+
+	void Renderer::recreate_swapchain() {
+		// frames in flight keep their old images, and the first frame on the new swapchain is
+		// queued behind the old presents, so the old swapchain retires once that frame completes
+		m_swapchain->recreate(m_framebuffer_size, m_frame_timeline->get_frame_value());
+		// present ids of the old swapchain can't be waited on anymore
+		m_latency_samples.clear();
+	}
+
+	void Renderer::pace_frame() {
+		SVE_PROFILE_ZONE("Pace frame");
+		m_frame_index = m_frame_timeline->begin_frame();
+		update_latency(is_low_latency());
+		m_input_time = std::chrono::steady_clock::now();
+	}
+
+	void Renderer::set_low_latency(bool const low_latency) {
+		if (low_latency == is_low_latency()) return;
+		if (m_swapchain) m_swapchain->set_low_latency(low_latency);
+		if (low_latency) {
+			m_throughput_frames_in_flight = get_frames_in_flight();
+			set_frames_in_flight(1);
+		}
+		else {
+			set_frames_in_flight(m_throughput_frames_in_flight);
+		}
+	}
+
+	void Renderer::update_latency(bool const wait) {
+		// bounded so a hidden window can't stall the loop
+		static constexpr auto present_timeout_v = std::chrono::nanoseconds{ 100ms };
+		auto completed = m_latency_samples.begin();
+		for (; completed != m_latency_samples.end(); ++completed) {
+			// a single frame in flight has already waited for the previous frame's timeline value
+			auto const done = completed->present_id > 0
+				? m_swapchain->wait_for_present(completed->present_id, wait ? present_timeout_v : 0ns)
+				: m_frame_timeline->is_complete(completed->frame_value);
+			if (!done) break;
+
+			// polled samples are observed up to a frame late, waited ones are exact
+			auto const latency = std::chrono::duration<float, std::milli>{ std::chrono::steady_clock::now() - completed->input_time };
+			m_stats.latency_ms = std::lerp(m_stats.latency_ms, latency.count(), 0.1f);
+		}
+		// a vector keeps its capacity, unlike a deque popping its front
+		m_latency_samples.erase(m_latency_samples.begin(), completed);
+	}
+
 	vk::CommandBuffer Renderer::begin_frame() {
 		auto const& render_sync = m_render_sync.at(m_frame_index);
 
 		auto command_buffer_bi = vk::CommandBufferBeginInfo{};
 		command_buffer_bi.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 		render_sync.command_buffer.begin(command_buffer_bi);
+
+		// the slot's previous frame has completed, so its timings are available
+		m_profiler->begin_frame(render_sync.command_buffer, m_frame_index);
+		m_stats.gpu_ms = m_profiler->get_frame_ms();
 		return render_sync.command_buffer;
 	}
 
 	void Renderer::transition_for_render(vk::CommandBuffer const command_buffer) const {
 		auto dependency_info = vk::DependencyInfo{};
-		auto barrier = m_swapchain.base_barrier();
+		auto barrier = m_swapchain ? m_swapchain->base_barrier() : m_offscreen->base_barrier();
 
 		barrier.setOldLayout(vk::ImageLayout::eUndefined)
 			.setNewLayout(vk::ImageLayout::eAttachmentOptimal)
@@ -293,7 +559,7 @@ namespace sve {
 
 	void Renderer::transition_for_present(vk::CommandBuffer const command_buffer) const {
 		auto dependency_info = vk::DependencyInfo{};
-		auto barrier = m_swapchain.base_barrier();
+		auto barrier = m_swapchain->base_barrier();
 
 		barrier.setOldLayout(vk::ImageLayout::eAttachmentOptimal)
 			.setNewLayout(vk::ImageLayout::ePresentSrcKHR)
@@ -309,76 +575,232 @@ namespace sve {
 	void Renderer::submit_and_present() {
 		auto const& render_sync = m_render_sync.at(m_frame_index);
 		render_sync.command_buffer.end();
+		m_uploads->flush();
 
 		auto submit_info = vk::SubmitInfo2{};
 		auto const command_buffer_info = vk::CommandBufferSubmitInfo{ render_sync.command_buffer };
-		auto wait_semaphore_info = vk::SemaphoreSubmitInfo{};
-		wait_semaphore_info.setSemaphore(*render_sync.draw)
-			.setStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput);
-		auto signal_semaphore_info = vk::SemaphoreSubmitInfo{};
-		signal_semaphore_info.setSemaphore(m_swapchain.get_present_semaphore())
+		auto acquire_semaphore_info = vk::SemaphoreSubmitInfo{};
+		acquire_semaphore_info.setSemaphore(*render_sync.draw)
 			.setStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+		// resources uploaded so far may be used by this frame
+		auto const wait_semaphore_infos = std::array{ m_uploads->get_wait_info(), acquire_semaphore_info };
+		auto present_semaphore_info = vk::SemaphoreSubmitInfo{};
+		if (m_swapchain) {
+			present_semaphore_info.setSemaphore(m_swapchain->get_present_semaphore())
+				.setStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+		}
+		auto const signal_semaphore_infos = std::array{ m_frame_timeline->get_signal_info(), present_semaphore_info };
+		// offscreen images are neither acquired nor presented
+		auto const semaphore_count = m_swapchain ? 2uz : 1uz;
 		submit_info.setCommandBufferInfos(command_buffer_info)
-			.setWaitSemaphoreInfos(wait_semaphore_info)
-			.setSignalSemaphoreInfos(signal_semaphore_info);
-		m_queue.submit2(submit_info, *render_sync.drawn);
+			.setWaitSemaphoreInfos(std::span{ wait_semaphore_infos }.first(semaphore_count))
+			.setSignalSemaphoreInfos(std::span{ signal_semaphore_infos }.first(semaphore_count));
+		m_queue.submit2(submit_info);
 
-		m_frame_index = (m_frame_index + 1) % m_render_sync.size();
+		m_frame_timeline->end_frame();
 
 		m_render_target.reset();
 
-		auto const fb_size_changed = m_framebuffer_size != m_swapchain.get_size();
-		auto const out_of_date = !m_swapchain.present(m_queue);
-		if (fb_size_changed || out_of_date)
+		if (!m_swapchain) {
+			m_latency_samples.push_back(LatencySample{
+				.frame_value = m_frame_timeline->get_submitted_value(),
+				.input_time = std::exchange(m_input_time, {})
+			});
+			return;
+		}
+
+		auto const fb_size_changed = m_framebuffer_size != m_swapchain->get_size();
+		auto const out_of_date = !m_swapchain->present(m_queue);
+		m_latency_samples.push_back(LatencySample{
+			.present_id = m_swapchain->get_present_id(),
+			.frame_value = m_frame_timeline->get_submitted_value(),
+			.input_time = std::exchange(m_input_time, {})
+		});
+		if (fb_size_changed || out_of_date || m_swapchain->is_stale())
 		{
-			m_swapchain.recreate(m_framebuffer_size);
+			recreate_swapchain();
+		}
+	}
+
+	void Renderer::draw_objects(vk::CommandBuffer const command_buffer, vk::RenderingInfo rendering_info) {
+		auto const start = std::chrono::steady_clock::now();
+		auto const batches = m_batcher.get_batches();
+		auto const chunk_count = m_recorder->get_chunk_count(batches.size());
+
+		if (chunk_count <= 1) {
+			// not enough work to pay for secondaries and thread hand-off
+			command_buffer.beginRendering(rendering_info);
+			m_stats.state_commands = draw_batches(command_buffer, batches);
+			command_buffer.endRendering();
+			m_stats.record_chunks = 0;
+		}
+		else {
+			auto inheritance_rendering_info = vk::CommandBufferInheritanceRenderingInfo{};
+			inheritance_rendering_info.setColorAttachmentFormats(m_format)
+				.setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+			auto chunk_counters = std::pmr::vector<StateCounters>(chunk_count, &m_frame_arena);
+			auto const record_chunk = [this, batches, &chunk_counters](vk::CommandBuffer const secondary, std::size_t const chunk_index, std::size_t const first, std::size_t const count) {
+				chunk_counters[chunk_index] = draw_batches(secondary, batches.subspan(first, count));
+				};
+			auto const secondaries = m_recorder->record(m_frame_index, inheritance_rendering_info, batches.size(), record_chunk);
+
+			rendering_info.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+			command_buffer.beginRendering(rendering_info);
+			command_buffer.executeCommands(secondaries);
+			command_buffer.endRendering();
+
+			m_stats.state_commands = {};
+			for (auto const& counters : chunk_counters) m_stats.state_commands += counters;
+			m_stats.record_chunks = static_cast<std::uint32_t>(secondaries.size());
 		}
+		m_stats.record_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 	}
 
-	void Renderer::draw_objects(vk::CommandBuffer const command_buffer) {
-		uint32_t ssbo_index = 0;
-		for (uint32_t i = 0; i < m_objects_to_draw.size(); i++)
+	void Renderer::draw_gpu_scene(vk::CommandBuffer const command_buffer) const {
+		bind_descriptor_sets(command_buffer);
+		// set 2 points at the instances compacted by the cull pass instead of the instance ring
+		auto const dynamic_offset = std::uint32_t{};
+		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_pipeline_layout, 2, m_gpu_scene->get_instance_set(m_frame_index), dynamic_offset);
+		auto const push_constants = InstancePushConstants{ .format = InstanceFormat::Affine };
+		command_buffer.pushConstants(*m_pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(push_constants), &push_constants);
+
+		static constexpr auto command_stride_v = std::uint32_t{ sizeof(vk::DrawIndexedIndirectCommand) };
+		auto const indirect_buffer = m_gpu_scene->get_command_buffer(m_frame_index);
+		auto const count_buffer = m_gpu_scene->get_count_buffer(m_frame_index);
+		auto state_cache = DynamicStateCache{ command_buffer };
+		m_geometry->bind(command_buffer);
+		for (auto const [index, segment] : std::views::enumerate(m_gpu_scene->get_segments())) {
+			m_resources.get(segment.shader).bind(state_cache, m_framebuffer_size);
+			command_buffer.drawIndexedIndirectCount(
+				indirect_buffer,
+				segment.first_command * command_stride_v,
+				count_buffer,
+				static_cast<vk::DeviceSize>(index) * sizeof(std::uint32_t),
+				segment.draw_count,
+				command_stride_v
+			);
+		}
+	}
+
+	// every command buffer starts without bound state, so each one binds its own sets and shaders
+	StateCounters Renderer::draw_batches(vk::CommandBuffer const command_buffer, std::span<DrawBatch const> batches) const {
+		bind_descriptor_sets(command_buffer);
+		auto state_cache = DynamicStateCache{ command_buffer };
+		m_geometry->bind(command_buffer);
+		for (auto const& batch : batches)
 		{
-			auto object = m_objects_to_draw[i];
+			auto const push_constants = InstancePushConstants{
+				.texture_index = batch.texture_index,
+				.format = m_instance_format
+			};
 			command_buffer.pushConstants(
 				*m_pipeline_layout,
-				vk::ShaderStageFlagBits::eFragment,
+				vk::ShaderStageFlagBits::eVertex,
 				0,
-				sizeof(uint32_t),
-				&object->texture_index
+				sizeof(push_constants),
+				&push_constants
+			);
+			m_resources.get(batch.shader).bind(state_cache, m_framebuffer_size);
+			auto const& mesh = m_resources.get(batch.mesh);
+			command_buffer.drawIndexed(
+				mesh.index_count,
+				batch.instance_count,
+				mesh.first_index,
+				static_cast<std::int32_t>(mesh.first_vertex),
+				m_first_instance + batch.first_instance
 			);
-			object->material.shader->bind(command_buffer, m_framebuffer_size);
-			command_buffer.bindVertexBuffers(0, object->mesh.vertex_buffer.get().buffer, vk::DeviceSize{});
-			command_buffer.bindIndexBuffer(object->mesh.vertex_buffer.get().buffer, 4 * sizeof(Vertex), vk::IndexType::eUint32);
-			command_buffer.drawIndexed(object->mesh.index_count, object->instance_count, 0, 0, ssbo_index);
-			ssbo_index += object->instance_count;
 		}
+		return state_cache.get_counters();
 	}
 
-	void Renderer::prepare_frame_resources() {
-		std::vector<Texture*> unique_textures;
+	void Renderer::cull_objects() {
+		auto const view = get_view_rect();
+
+		// frame temporaries, sized for the worst case so they never regrow
+		auto visible = std::pmr::vector<std::uint32_t>{ &m_frame_arena };
+		visible.reserve(m_spatial_index.size());
+		m_spatial_index.query(view, visible);
+		m_render_queue.begin_frame(m_frame_arena, visible.size() + m_submissions.size());
+		for (auto const index : visible) {
+			auto const& retained = m_retained[index];
+			m_render_queue.push(*retained.object, retained.info);
+		}
 
-		unique_textures.reserve(m_objects_to_draw.size());
+		auto submitted_visible = 0uz;
+		for (auto const& submission : m_submissions) {
+			auto const& object = *submission.object;
+			if (!transform_bounds(object.transform, m_resources.get(object.mesh).bounds).overlaps(view)) continue;
+			m_render_queue.push(*submission.object, submission.info);
+			++submitted_visible;
+		}
 
-		for (auto& obj : m_objects_to_draw) {
-			if (std::ranges::find(unique_textures, obj->material.texture) == unique_textures.end())
-				unique_textures.push_back(obj->material.texture);
+		m_stats.culled = static_cast<std::uint32_t>(m_spatial_index.size() - visible.size() + m_submissions.size() - submitted_visible);
+	}
 
-			for (auto& obj : m_objects_to_draw) {
-				obj->texture_index = static_cast<uint32_t>(std::ranges::find(unique_textures, obj->material.texture) - unique_textures.begin());
-			}
+	void Renderer::build_batches() {
+		cull_objects();
+		m_render_queue.sort();
+		m_batcher.build(m_render_queue, m_resources, *m_jobs, m_frame_arena);
+
+		m_stats.objects = static_cast<std::uint32_t>(m_render_queue.size());
+		m_stats.instances = m_batcher.get_instance_count();
+		m_stats.batches = static_cast<std::uint32_t>(m_batcher.get_batches().size());
+	}
+
+	void Renderer::submit(Object& object, SubmitInfo const& info) {
+		m_submissions.push_back(Submission{ .object = &object, .info = info });
+	}
 
-			update_textures_array(unique_textures);
+	void Renderer::add(Object& object, SubmitInfo const& info) {
+		assert(object.proxy == SpatialGrid::invalid_proxy_v);
+		auto index = std::uint32_t{};
+		if (!m_free_retained.empty()) {
+			index = m_free_retained.back();
+			m_free_retained.pop_back();
 		}
+		else {
+			index = static_cast<std::uint32_t>(m_retained.size());
+			m_retained.emplace_back();
+		}
+		m_retained[index] = Submission{ .object = &object, .info = info };
+		object.proxy = m_spatial_index.insert(transform_bounds(object.transform, m_resources.get(object.mesh).bounds), index);
+	}
+
+	void Renderer::update(Object const& object) {
+		m_spatial_index.update(object.proxy, transform_bounds(object.transform, m_resources.get(object.mesh).bounds));
+	}
+
+	MeshHandle Renderer::create_mesh(std::span<Vertex const> const vertices, std::span<std::uint32_t const> const indices) {
+		return m_resources.add(m_geometry->create_mesh(vertices, indices));
 	}
 
-	void Renderer::submit(Object& object) {
-		m_objects_to_draw.push_back(&object);
+	SamplerHandle Renderer::create_sampler(vk::SamplerCreateInfo const& create_info) {
+		return m_resources.add(m_device.createSamplerUnique(create_info));
+	}
+
+	void Renderer::remove(Object& object) {
+		m_free_retained.push_back(m_spatial_index.get_payload(object.proxy));
+		m_spatial_index.remove(object.proxy);
+		object.proxy = SpatialGrid::invalid_proxy_v;
 	}
 
 	void Renderer::draw(Color clear_color) {
-		if (!acquire_render_target()) return;
-		prepare_frame_resources();
+		// a CPU frame runs from one draw to the next, so it includes what the caller did in between
+		cpu_profiler::end_frame();
+		SVE_PROFILE_ZONE("Draw");
+		m_frame_arena.reset();
+		// without pace_frame() input is assumed to be sampled right before drawing
+		if (m_input_time == std::chrono::steady_clock::time_point{}) m_input_time = std::chrono::steady_clock::now();
+		update_latency(false);
+		{
+			SVE_PROFILE_ZONE("Acquire");
+			if (!acquire_render_target()) return;
+		}
+		{
+			SVE_PROFILE_ZONE("Build batches");
+			build_batches();
+		}
 
 		auto const command_buffer = begin_frame();
 		transition_for_render(command_buffer);
@@ -395,33 +817,69 @@ namespace sve {
 			.setColorAttachments(color_attachment)
 			.setLayerCount(1);
 
-		bind_descriptor_sets(command_buffer);
-
-		
-		inspect();
-		update_instance_ssbo();
-		update_view();
-
+		if (m_imgui) inspect();
+		{
+			SVE_PROFILE_ZONE("Update buffers");
+			// write before binding, the buffers may be reallocated when they grow
+			update_instance_ssbo();
+			update_view();
 
-		command_buffer.beginRendering(rendering_info);
+			write_descriptor_sets();
+		}
 
-		draw_objects(command_buffer);
-		
+		m_stats.gpu_objects = m_gpu_scene ? m_gpu_scene->get_object_count() : 0;
+		{
+			auto const scene_scope = m_profiler->scope(command_buffer, "Scene");
+			if (m_stats.gpu_objects > 0) {
+				{
+					auto const cull_scope = m_profiler->scope(command_buffer, "Cull");
+					m_gpu_scene->cull(command_buffer, m_frame_index, get_view_rect());
+				}
+				auto const gpu_scene_scope = m_profiler->scope(command_buffer, "GPU scene");
+				command_buffer.beginRendering(rendering_info);
+				draw_gpu_scene(command_buffer);
+				command_buffer.endRendering();
+				// submitted objects draw on top
+				color_attachment.setLoadOp(vk::AttachmentLoadOp::eLoad);
+			}
 
-		command_buffer.endRendering();
+			auto const batches_scope = m_profiler->scope(command_buffer, "Batches");
+			SVE_PROFILE_ZONE("Record batches");
+			draw_objects(command_buffer, rendering_info);
+		}
 
-		m_imgui->end_frame();
+		if (m_imgui) {
+			m_imgui->end_frame();
 
-		color_attachment.setLoadOp(vk::AttachmentLoadOp::eLoad);
-		rendering_info.setColorAttachments(color_attachment)
-			.setPDepthAttachment(nullptr);
-		command_buffer.beginRendering(rendering_info);
-		m_imgui->render(command_buffer);
-		command_buffer.endRendering();
+			auto const imgui_scope = m_profiler->scope(command_buffer, "ImGui");
+			color_attachment.setLoadOp(vk::AttachmentLoadOp::eLoad);
+			rendering_info.setColorAttachments(color_attachment)
+				.setPDepthAttachment(nullptr);
+			command_buffer.beginRendering(rendering_info);
+			m_imgui->render(command_buffer);
+			command_buffer.endRendering();
+		}
 
-		transition_for_present(command_buffer);
-		submit_and_present();
+		auto defragmented = false;
+		{
+			auto const defragment_scope = m_profiler->scope(command_buffer, "Defragment");
+			defragmented = m_defragmenter->record(command_buffer);
+		}
+		if (m_swapchain) transition_for_present(command_buffer);
+		{
+			SVE_PROFILE_ZONE("Submit and present");
+			submit_and_present();
+		}
+		if (defragmented) {
+			// uploads from now on write the moved buffers, which this frame's copies still fill
+			auto wait_info = vk::SemaphoreSubmitInfo{};
+			wait_info.setSemaphore(m_frame_timeline->get_semaphore())
+				.setValue(m_frame_timeline->get_submitted_value())
+				.setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+			m_uploads->add_wait(wait_info);
+		}
 
-		m_objects_to_draw.clear();
+		m_render_queue.clear();
+		m_submissions.clear();
 	}
 }
\ No newline at end of file
@@ -5,37 +5,162 @@
 #include "utils/transform.hpp"
 #include "gpu.hpp"
 #include "descriptor_buffer.hpp"
+#include "ring_buffer.hpp"
 #include "render_target.hpp"
 #include "swapchain.hpp"
+#include "offscreen_target.hpp"
 #include "dear_imgui.hpp"
 #include "utils/color.hpp"
 #include "utils/object.hpp"
+#include "draw_batcher.hpp"
+#include "render_queue.hpp"
+#include "state_cache.hpp"
+#include "command_recorder.hpp"
+#include "gpu_scene.hpp"
+#include "spatial_grid.hpp"
+#include "texture_registry.hpp"
+#include "resource_registry.hpp"
+#include "frame_timeline.hpp"
+#include "deletion_queue.hpp"
+#include "upload_queue.hpp"
+#include "geometry_arena.hpp"
+#include "frame_arena.hpp"
+#include "gpu_profiler.hpp"
+#include "defragmenter.hpp"
+#include "utils/instance.hpp"
 #include <imgui.h>
 #include <vulkan/vulkan.hpp>
+#include <chrono>
 
 
 namespace sve {
 	struct RendererCreateInfo {
 		vk::Device device{};
 		Gpu gpu{};
+		// null with a null swapchain, which also disables the inspector
 		GLFWwindow* window{};
 		vk::Queue queue{};
+		// of gpu.transfer_queue_family, uploads go through queue when null
+		vk::Queue transfer_queue{};
 		vk::Instance instance{};
 		vk::Format format{};
-		Swapchain& swapchain;
-		VmaAllocator* allocator{};
+		// null renders headless into offscreen images of headless_size, format is then ignored
+		Swapchain* swapchain{};
+		glm::ivec2 headless_size{ 1280, 720 };
+		vma::RawAllocator* allocator{};
+		// runs instance gathering, transform evaluation and command recording
+		JobSystem* jobs{};
+		// compiled cull.comp, the GPU-driven path is disabled when empty
+		std::span<std::uint32_t const> cull_spirv{};
+		// more frames raise throughput at the cost of input latency, adjustable at runtime
+		std::uint32_t frames_in_flight{ static_cast<std::uint32_t>(default_frames_in_flight_v) };
+	};
+
+	struct RenderStats {
+		std::uint32_t objects{};
+		// objects outside the view, skipped before batching
+		std::uint32_t culled{};
+		std::uint32_t instances{};
+		std::uint32_t batches{};
+		StateCounters state_commands{};
+		// secondary command buffers recorded in parallel, 0 when recorded inline
+		std::uint32_t record_chunks{};
+		float record_ms{};
+		std::uint32_t gpu_objects{};
+		// smoothed time from pace_frame() to the image being presented, or to GPU completion without present wait
+		float latency_ms{};
+		// GPU time of the latest completed frame, 0 without the GPU profiler
+		float gpu_ms{};
 	};
 
 	class Renderer {
 	public:
 		using CreateInfo = RendererCreateInfo;
+
+		static constexpr auto push_constant_ranges_v = std::array{
+			vk::PushConstantRange{ vk::ShaderStageFlagBits::eVertex, 0, sizeof(InstancePushConstants) }
+		};
+
 		explicit Renderer(CreateInfo& create_info);
+		// waits for the frames this renderer submitted, not the whole device
+		~Renderer();
 
-		void submit(Object& object);
+		Renderer(Renderer const&) = delete;
+		Renderer& operator=(Renderer const&) = delete;
+		Renderer(Renderer&&) = delete;
+		Renderer& operator=(Renderer&&) = delete;
+
+		// call before polling input: waits for a free frame slot and, in low latency mode, for the previous present
+		void pace_frame();
+		// drawn in the next frame only
+		void submit(Object& object, SubmitInfo const& info = {});
+		// drawn every frame until removed, culled through the spatial index
+		void add(Object& object, SubmitInfo const& info = {});
+		// must be called after a retained object's transform or mesh changed
+		void update(Object const& object);
+		void remove(Object& object);
 		void draw(Color clear_color = Color::Black);
 
+		[[nodiscard]] RenderStats const& get_stats() const { return m_stats; }
+		// without it RenderStats::gpu_ms stays 0
+		[[nodiscard]] bool has_gpu_timestamps() const { return m_profiler->is_enabled(); }
+		// times the passes of every frame, compiled out unless SVE_GPU_PROFILER is set
+		[[nodiscard]] GpuProfiler& get_gpu_profiler() { return *m_profiler; }
+
+		[[nodiscard]] TextureRegistry& get_texture_registry() { return *m_texture_registry; }
+		// owns everything objects refer to by handle, see destroy()
+		[[nodiscard]] ResourceRegistry& get_resources() { return m_resources; }
+		[[nodiscard]] ResourceRegistry const& get_resources() const { return m_resources; }
+		// flushed with every frame, which waits for the uploads on the GPU
+		[[nodiscard]] UploadQueue& get_upload_queue() { return *m_uploads; }
+		[[nodiscard]] GeometryArena& get_geometry_arena() { return *m_geometry; }
+		// compacts the geometry arena's memory in the background
+		[[nodiscard]] Defragmenter& get_defragmenter() { return *m_defragmenter; }
+		[[nodiscard]] vma::MemoryStats get_memory_stats() const { return vma::get_memory_stats(m_allocator); }
+		// for CPU temporaries, everything allocated from it is released when the next draw() starts
+		[[nodiscard]] FrameArena& get_frame_arena() { return m_frame_arena; }
+		// suballocates the mesh from the geometry arena and registers it
+		[[nodiscard]] MeshHandle create_mesh(std::span<Vertex const> vertices, std::span<std::uint32_t const> indices);
+		[[nodiscard]] SamplerHandle create_sampler(vk::SamplerCreateInfo const& create_info);
+		// unregisters the resource and frees it once the frames that may use it have completed,
+		// a mesh's arena ranges go back to the arena
+		template <typename Type>
+		void destroy(Handle<Type> const handle) {
+			if constexpr (std::same_as<Type, Mesh>) m_geometry->release(m_resources.take(handle), m_frame_timeline->get_frame_value());
+			else defer_delete(m_resources.take(handle));
+		}
+		// persistent objects culled and drawn by the GPU, null when the device or assets lack support
+		[[nodiscard]] GpuScene* get_gpu_scene() { return m_gpu_scene ? &*m_gpu_scene : nullptr; }
+		// world space rectangle covered by the current view
+		[[nodiscard]] Rect get_view_rect() const;
+
+		// Affine halves instance upload, Matrix keeps full model matrices for 3D transforms
+		void set_instance_format(InstanceFormat const format) { m_instance_format = format; }
+		[[nodiscard]] InstanceFormat get_instance_format() const { return m_instance_format; }
+
+		// 1 to resource_buffering_v, takes effect from the next frame
+		void set_frames_in_flight(std::uint32_t const count) { m_frame_timeline->set_frames_in_flight(count); }
+		[[nodiscard]] std::uint32_t get_frames_in_flight() const { return m_frame_timeline->get_frames_in_flight(); }
+		// false if the surface does not support mode, or when headless
+		bool set_present_mode(vk::PresentModeKHR const mode) { return m_swapchain && m_swapchain->set_present_mode(mode); }
+		// immediate when headless, frames are never throttled by presentation
+		[[nodiscard]] vk::PresentModeKHR get_present_mode() const { return m_swapchain ? m_swapchain->get_present_mode() : vk::PresentModeKHR::eImmediate; }
+		// one frame in flight and the shortest swapchain queue, trades throughput for input latency
+		void set_low_latency(bool low_latency);
+		[[nodiscard]] bool is_low_latency() const { return m_swapchain ? m_swapchain->is_low_latency() : get_frames_in_flight() == 1; }
+		// renders into offscreen images, without a window or surface
+		[[nodiscard]] bool is_headless() const { return m_swapchain == nullptr; }
+
+		// each submitted frame signals the next value, wait on it to know when its resources are free
+		[[nodiscard]] FrameTimeline const& get_frame_timeline() const { return *m_frame_timeline; }
+
+		// destroys a resource once every frame recorded so far, including the current one, has completed
+		template <typename Type>
+		void defer_delete(Type&& resource) {
+			m_deletion_queue.push(m_frame_timeline->get_frame_value(), std::forward<Type>(resource));
+		}
+
 		std::vector<vk::DescriptorSetLayout> m_set_layout_views{};
-		vk::UniqueCommandPool m_cmd_block_pool{};
 	private:
 		Gpu m_gpu{};
 		vk::Device m_device{};
@@ -43,57 +168,111 @@ namespace sve {
 		vk::Instance m_instance{};
 		vk::Queue m_queue{};
 		vk::Format m_format{};
-		Swapchain& m_swapchain;
-		VmaAllocator m_allocator{};
+		// null when headless, m_offscreen is used instead
+		Swapchain* m_swapchain{};
+		std::optional<OffscreenTarget> m_offscreen{};
+		vma::RawAllocator m_allocator{};
+		JobSystem* m_jobs{};
 
 		struct RenderSync {
 			vk::UniqueSemaphore draw{};
-			vk::UniqueFence drawn{};
 			vk::CommandBuffer command_buffer{};
 		};
 
 		glm::ivec2 m_framebuffer_size{};
 		vk::UniqueCommandPool m_render_cmd_pool{};
 		Buffered<RenderSync> m_render_sync{};
+		std::optional<GpuProfiler> m_profiler{};
+		std::optional<FrameTimeline> m_frame_timeline{};
 		std::size_t m_frame_index{};
+		DeletionQueue m_deletion_queue{};
+		std::optional<UploadQueue> m_uploads{};
+		// outlives the buffers it tracks
+		std::optional<Defragmenter> m_defragmenter{};
+		std::optional<GeometryArena> m_geometry{};
+		FrameArena m_frame_arena{};
+
+		struct LatencySample {
+			std::uint64_t present_id{};
+			std::uint64_t frame_value{};
+			std::chrono::steady_clock::time_point input_time{};
+		};
+
+		// oldest first, only a few frames are ever pending
+		std::vector<LatencySample> m_latency_samples{};
+		std::chrono::steady_clock::time_point m_input_time{};
+		// frames in flight outside low latency mode
+		std::uint32_t m_throughput_frames_in_flight{};
 
 		std::optional<RenderTarget> m_render_target{};
 		std::optional<DearImGui> m_imgui{};
 
+		std::optional<TextureRegistry> m_texture_registry{};
+		// textures release their bindless slots, destroyed before the registry
+		ResourceRegistry m_resources{};
 		vk::UniqueDescriptorPool m_descriptor_pool{};
 		std::vector<vk::UniqueDescriptorSetLayout> m_set_layouts{};
 		vk::UniquePipelineLayout m_pipeline_layout{};
 		Buffered<std::vector<vk::DescriptorSet>> m_descriptor_sets{};
 
 		std::optional<DescriptorBuffer> m_view_ubo{};
-		std::optional<DescriptorBuffer> m_instance_ssbo;
+		std::optional<RingBuffer> m_instance_ring{};
+		Buffered<std::uint64_t> m_instance_ring_generations{};
+		std::uint32_t m_first_instance{};
+		InstanceFormat m_instance_format{ InstanceFormat::Affine };
 		Transform m_view_transform{};
 
-		std::vector<Object*> m_objects_to_draw{};
+		std::optional<CommandRecorder> m_recorder{};
+		std::optional<GpuScene> m_gpu_scene{};
+
+		struct Submission {
+			Object* object{};
+			SubmitInfo info{};
+		};
+
+		std::vector<Submission> m_submissions{};
+		std::vector<Submission> m_retained{};
+		std::vector<std::uint32_t> m_free_retained{};
+		SpatialGrid m_spatial_index{};
+
+		RenderQueue m_render_queue{};
+		DrawBatcher m_batcher{};
+		RenderStats m_stats{};
 
 		bool m_wireframe{};
 
-		void create_render_sync();
+		void create_render_sync(std::uint32_t frames_in_flight);
 		void create_imgui();
 		void create_descriptor_pool();
 		void create_pipeline_layout();
-		void create_cmd_block_pool();
 		void create_descriptor_sets();
 
 		void inspect();
+		void inspect_timings();
+		void inspect_gpu_timeline();
+		void inspect_cpu_zones();
+		void inspect_memory();
+		// deletion queue entries, released mesh ranges and retired swapchains
+		[[nodiscard]] std::size_t get_pending_deletions() const;
+		[[nodiscard]] bool evict();
 		void update_view();
 		void update_instance_ssbo();
+		void write_descriptor_sets();
 		void bind_descriptor_sets(vk::CommandBuffer const command_buffer) const;
-		void update_textures_array(std::span<Texture*> textures);
 
 		vk::CommandBuffer begin_frame();
 		void transition_for_render(vk::CommandBuffer command_buffer) const;
 		void transition_for_present(vk::CommandBuffer command_buffer) const;
 		void submit_and_present();
+		void recreate_swapchain();
+		void update_latency(bool wait);
 
 
-		void draw_objects(vk::CommandBuffer const command_buffer);
-		void prepare_frame_resources();
+		void draw_objects(vk::CommandBuffer const command_buffer, vk::RenderingInfo rendering_info);
+		void draw_gpu_scene(vk::CommandBuffer const command_buffer) const;
+		[[nodiscard]] StateCounters draw_batches(vk::CommandBuffer const command_buffer, std::span<DrawBatch const> batches) const;
+		void cull_objects();
+		void build_batches();
 
 		[[nodiscard]] std::vector<vk::DescriptorSet> allocate_sets() const;
 		[[nodiscard]] bool acquire_render_target();
@@ -2,8 +2,11 @@
 #include <array>
 
 namespace sve {
-	inline constexpr std::size_t resource_buffering_v{ 2 };
+	// upper bound for frames in flight, the count actually used is picked at runtime
+	inline constexpr std::size_t resource_buffering_v{ 4 };
+	inline constexpr std::size_t default_frames_in_flight_v{ 2 };
 
+	// one slot per possible frame in flight, only the first get_frames_in_flight() are cycled
 	template <typename Type>
 	using Buffered = std::array<Type, resource_buffering_v>;
-}
\ No newline at end of file
+}
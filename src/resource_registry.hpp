@@ -0,0 +1,51 @@
+#pragma once
+#include "slot_map.hpp"
+#include "shader_program.hpp"
+#include "texture.hpp"
+#include "utils/object.hpp"
+#include <vulkan/vulkan.hpp>
+#include <concepts>
+
+namespace sve {
+	using SamplerHandle = Handle<vk::UniqueSampler>;
+
+	// Owns the shaders, textures, meshes and samplers objects are drawn with. Everything else refers
+	// to them by handle: lookups are O(1), stale handles are detected, and handle indices double as
+	// small ids for sort keys. Values move when others are removed, so don't keep pointers to them.
+	class ResourceRegistry {
+	public:
+		template <typename Type>
+		[[nodiscard]] Handle<Type> add(Type resource) { return map_of<Type>(*this).insert(std::move(resource)); }
+		// removes the resource and hands it to the caller, the handle is stale afterwards
+		template <typename Type>
+		[[nodiscard]] Type take(Handle<Type> const handle) { return map_of<Type>(*this).take(handle); }
+
+		template <typename Type>
+		[[nodiscard]] bool contains(Handle<Type> const handle) const { return map_of<Type>(*this).contains(handle); }
+		// throws std::out_of_range if the handle is stale
+		template <typename Type>
+		[[nodiscard]] Type const& get(Handle<Type> const handle) const { return map_of<Type>(*this).get(handle); }
+		template <typename Type>
+		[[nodiscard]] Type& get(Handle<Type> const handle) { return map_of<Type>(*this).get(handle); }
+
+		template <typename Type>
+		[[nodiscard]] SlotMap<Type> const& get_all() const { return map_of<Type>(*this); }
+
+	private:
+		template <typename Type, typename Self>
+		[[nodiscard]] static auto& map_of(Self& self) {
+			if constexpr (std::same_as<Type, ShaderProgram>) return self.m_shaders;
+			else if constexpr (std::same_as<Type, Texture>) return self.m_textures;
+			else if constexpr (std::same_as<Type, Mesh>) return self.m_meshes;
+			else {
+				static_assert(std::same_as<Type, vk::UniqueSampler>, "Type is not a registry resource");
+				return self.m_samplers;
+			}
+		}
+
+		SlotMap<ShaderProgram> m_shaders{};
+		SlotMap<Texture> m_textures{};
+		SlotMap<Mesh> m_meshes{};
+		SlotMap<vk::UniqueSampler> m_samplers{};
+	};
+}
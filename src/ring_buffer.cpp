@@ -0,0 +1,61 @@
+#include "ring_buffer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace sve {
+	namespace {
+		[[nodiscard]] constexpr vk::DeviceSize align_up(vk::DeviceSize const value, vk::DeviceSize const alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	RingBuffer::RingBuffer(CreateInfo const& create_info) : m_info(create_info) {
+		grow(m_info.initial_partition_size);
+	}
+
+	void RingBuffer::begin_frame(std::size_t const frame_index) {
+		m_frame_index = frame_index;
+		m_head = 0;
+		m_retired.at(m_frame_index).clear();
+	}
+
+	vk::DescriptorBufferInfo RingBuffer::get_descriptor_info() const {
+		auto ret = vk::DescriptorBufferInfo{};
+		ret.setBuffer(m_buffer.get().buffer).setRange(m_partition_size);
+		return ret;
+	}
+
+	vk::DeviceSize RingBuffer::allocate_bytes(vk::DeviceSize const size, vk::DeviceSize const element_size) {
+		auto const offset = align_up(m_head, element_size);
+		if (offset + size > m_partition_size) {
+			grow(std::max(2 * m_partition_size, offset + size));
+		}
+		m_head = offset + size;
+		return offset;
+	}
+
+	void RingBuffer::grow(vk::DeviceSize const min_partition_size) {
+		auto const partition_size = align_up(min_partition_size, m_info.alignment);
+		auto const buffer_ci = vma::BufferCreateInfo{
+			.allocator = m_info.allocator,
+			.usage = m_info.usage,
+			.queue_family = m_info.queue_family
+		};
+		auto buffer = vma::create_buffer(buffer_ci, vma::BufferMemoryType::Host, partition_size * resource_buffering_v);
+		if (!buffer.get().buffer) {
+			throw std::runtime_error{ "Failed to create ring buffer" };
+		}
+
+		if (m_buffer.get().buffer) {
+			// keep what this frame already wrote, the other partitions still live in the old buffer
+			auto const src = m_buffer.get().mapped_span().subspan(partition_base(), m_head);
+			std::memcpy(buffer.get().mapped_span().subspan(m_frame_index * partition_size).data(), src.data(), src.size());
+			m_retired.at(m_frame_index).push_back(std::move(m_buffer));
+		}
+
+		m_buffer = std::move(buffer);
+		m_partition_size = partition_size;
+		++m_generation;
+	}
+}
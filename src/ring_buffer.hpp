@@ -0,0 +1,69 @@
+#pragma once
+#include "vma.hpp"
+#include "resource_buffering.hpp"
+#include <vulkan/vulkan.hpp>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace sve {
+	struct RingBufferCreateInfo {
+		vma::RawAllocator allocator{};
+		std::uint32_t queue_family{};
+		vk::BufferUsageFlags usage{};
+		// minimum dynamic offset alignment for the usage, eg minStorageBufferOffsetAlignment
+		vk::DeviceSize alignment{ 256 };
+		vk::DeviceSize initial_partition_size{ 64 * 1024 };
+	};
+
+	template <typename Type>
+	struct RingAllocation {
+		std::span<Type> data{};
+		// index of data.front() relative to the frame's dynamic offset
+		std::uint32_t first_element{};
+	};
+
+	// One persistently mapped host-visible buffer split into a partition per frame in flight.
+	// Callers write straight into the mapped memory and bind the frame's partition with a dynamic offset.
+	class RingBuffer {
+	public:
+		using CreateInfo = RingBufferCreateInfo;
+
+		explicit RingBuffer(CreateInfo const& create_info);
+
+		// must be called once the GPU is done with the previous use of frame_index
+		void begin_frame(std::size_t frame_index);
+
+		// spans handed out earlier in the same frame are invalidated if this grows the buffer
+		template <typename Type>
+		[[nodiscard]] RingAllocation<Type> allocate(std::size_t const count) {
+			static_assert(std::is_trivially_copyable_v<Type>);
+			auto const offset = allocate_bytes(count * sizeof(Type), sizeof(Type));
+			auto* data = static_cast<void*>(m_buffer.get().mapped_span().subspan(partition_base() + offset).data());
+			return RingAllocation<Type>{
+				.data = std::span{ static_cast<Type*>(data), count },
+				.first_element = static_cast<std::uint32_t>(offset / sizeof(Type))
+			};
+		}
+
+		[[nodiscard]] std::uint32_t get_dynamic_offset() const { return static_cast<std::uint32_t>(partition_base()); }
+		[[nodiscard]] vk::DescriptorBufferInfo get_descriptor_info() const;
+		// incremented whenever the underlying buffer is replaced, descriptors must be rewritten then
+		[[nodiscard]] std::uint64_t get_generation() const { return m_generation; }
+
+	private:
+		[[nodiscard]] vk::DeviceSize partition_base() const { return m_frame_index * m_partition_size; }
+		[[nodiscard]] vk::DeviceSize allocate_bytes(vk::DeviceSize size, vk::DeviceSize element_size);
+		void grow(vk::DeviceSize min_partition_size);
+
+		CreateInfo m_info{};
+		vma::Buffer m_buffer{};
+		vk::DeviceSize m_partition_size{};
+		vk::DeviceSize m_head{};
+		std::size_t m_frame_index{};
+		std::uint64_t m_generation{};
+
+		// replaced buffers stay alive until the frame that retired them comes around again
+		Buffered<std::vector<vma::Buffer>> m_retired{};
+	};
+}
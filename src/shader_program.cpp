@@ -1,19 +1,15 @@
 #include "shader_program.hpp"
+#include "state_cache.hpp"
 #include <vulkan/vulkan.hpp>
 
 namespace sve {
-	namespace {
-		constexpr auto to_vkbool(bool const value) {
-			return value ? vk::True : vk::False;
-		}
-	}
-
 	ShaderProgram::ShaderProgram(CreateInfo const& create_info) : m_vertex_input(create_info.vertex_input) {
 		auto const create_shader_ci = [&create_info](std::span<std::uint32_t const> spirv) {
 			auto ret = vk::ShaderCreateInfoEXT{};
 			ret.setCodeSize(spirv.size_bytes())
 				.setPCode(spirv.data())
 				.setSetLayouts(create_info.set_layouts)
+				.setPushConstantRanges(create_info.push_constant_ranges)
 				.setCodeType(vk::ShaderCodeTypeEXT::eSpirv)
 				.setPName("main");
 			return ret;
@@ -33,73 +29,29 @@ namespace sve {
 			throw std::runtime_error{ "Failed to create shader objects" };
 		}
 		m_shaders = std::move(result.value);
-		m_waiter = create_info.device;
-	}
-
-	void ShaderProgram::bind(vk::CommandBuffer command_buffer, glm::ivec2 framebuffer_size) const {
-		set_viewport_scissor(command_buffer, framebuffer_size);
-		set_static_states(command_buffer);
-		set_common_states(command_buffer);
-		set_vertex_states(command_buffer);
-		set_fragment_states(command_buffer);
-		bind_shaders(command_buffer);
-	}
-
-	void ShaderProgram::set_viewport_scissor(vk::CommandBuffer const command_buffer, glm::ivec2 const framebuffer_size) {
-		auto const fsize = glm::vec2{ framebuffer_size };
-		auto viewport = vk::Viewport{};
-
-		viewport.setX(0.0f).setY(fsize.y).setWidth(fsize.x).setHeight(-fsize.y);
-		command_buffer.setViewportWithCount(viewport);
-
-		auto const usize = glm::uvec2{ framebuffer_size };
-		auto const scissor = vk::Rect2D{ vk::Offset2D{}, vk::Extent2D{usize.x, usize.y} };
-		command_buffer.setScissorWithCount(scissor);
-	}
-
-	void ShaderProgram::set_static_states(vk::CommandBuffer const command_buffer) {
-		command_buffer.setRasterizerDiscardEnable(vk::False);
-		command_buffer.setRasterizationSamplesEXT(vk::SampleCountFlagBits::e1);
-		command_buffer.setSampleMaskEXT(vk::SampleCountFlagBits::e1, 0xff);
-		command_buffer.setAlphaToCoverageEnableEXT(vk::False);
-		command_buffer.setCullMode(vk::CullModeFlagBits::eNone);
-		command_buffer.setFrontFace(vk::FrontFace::eCounterClockwise);
-		command_buffer.setDepthBiasEnable(vk::False);
-		command_buffer.setStencilTestEnable(vk::False);
-		command_buffer.setPrimitiveRestartEnable(vk::False);
-		command_buffer.setColorWriteMaskEXT(0, ~vk::ColorComponentFlags{});
 	}
 
-	void ShaderProgram::set_common_states(vk::CommandBuffer const command_buffer) const {
-		auto const depth_test = to_vkbool((flags & DepthTest) == DepthTest);
-		command_buffer.setDepthWriteEnable(depth_test);
-		command_buffer.setDepthTestEnable(depth_test);
-		command_buffer.setDepthCompareOp(depth_compare_op);
-		command_buffer.setPolygonModeEXT(polygon_mode);
-		command_buffer.setLineWidth(line_width);
+	void ShaderProgram::bind(DynamicStateCache& state_cache, glm::ivec2 const framebuffer_size) const {
+		state_cache.set_viewport_scissor(framebuffer_size);
+		state_cache.set_static_states();
+		set_common_states(state_cache);
+		set_vertex_states(state_cache);
+		set_fragment_states(state_cache);
+		state_cache.bind_shaders(*m_shaders[0], *m_shaders[1]);
 	}
 
-	void ShaderProgram::set_vertex_states(vk::CommandBuffer const command_buffer) const {
-		command_buffer.setVertexInputEXT(m_vertex_input.bindings, m_vertex_input.attributes);
-		command_buffer.setPrimitiveTopology(topology);
+	void ShaderProgram::set_common_states(DynamicStateCache& state_cache) const {
+		state_cache.set_depth((flags & DepthTest) == DepthTest, depth_compare_op);
+		state_cache.set_polygon_mode(polygon_mode);
+		state_cache.set_line_width(line_width);
 	}
 
-	void ShaderProgram::set_fragment_states(vk::CommandBuffer const command_buffer) const {
-		auto const alpha_blend = to_vkbool((flags & AlphaBlend) == AlphaBlend);
-		command_buffer.setColorBlendEnableEXT(0, alpha_blend);
-		command_buffer.setColorBlendEquationEXT(0, color_blend_equation);
+	void ShaderProgram::set_vertex_states(DynamicStateCache& state_cache) const {
+		state_cache.set_vertex_input(m_vertex_input);
+		state_cache.set_topology(topology);
 	}
 
-	void ShaderProgram::bind_shaders(vk::CommandBuffer const command_buffer) const {
-		static constexpr auto stages_v = std::array{
-			vk::ShaderStageFlagBits::eVertex,
-			vk::ShaderStageFlagBits::eFragment
-		};
-
-		auto const shaders = std::array{
-			*m_shaders[0],
-			*m_shaders[1]
-		};
-		command_buffer.bindShadersEXT(stages_v, shaders);
+	void ShaderProgram::set_fragment_states(DynamicStateCache& state_cache) const {
+		state_cache.set_blend((flags & AlphaBlend) == AlphaBlend, color_blend_equation);
 	}
 }
\ No newline at end of file
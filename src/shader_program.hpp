@@ -1,10 +1,11 @@
 #pragma once
-#include "scoped_waiter.hpp"
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
 
 namespace sve 
 {
+	class DynamicStateCache;
+
 	struct ShaderVertexInput {
 		std::span<vk::VertexInputAttributeDescription2EXT const> attributes{};
 		std::span<vk::VertexInputBindingDescription2EXT const> bindings{};
@@ -17,6 +18,7 @@ namespace sve
 		std::span<std::uint32_t const> fragment_spirv;
 		ShaderVertexInput vertex_input;
 		std::span<vk::DescriptorSetLayout const> set_layouts;
+		std::span<vk::PushConstantRange const> push_constant_ranges;
 	};
 
 	class ShaderProgram
@@ -43,7 +45,7 @@ namespace sve
 
 		explicit ShaderProgram(CreateInfo const& create_info);
 
-		void bind(vk::CommandBuffer command_buffer, glm::ivec2 framebuffer_size) const;
+		void bind(DynamicStateCache& state_cache, glm::ivec2 framebuffer_size) const;
 
 		vk::PrimitiveTopology topology{ vk::PrimitiveTopology::eTriangleList };
 		vk::PolygonMode polygon_mode{ vk::PolygonMode::eFill };
@@ -52,17 +54,11 @@ namespace sve
 		vk::CompareOp depth_compare_op{ vk::CompareOp::eLessOrEqual };
 		std::uint8_t flags{ flags_v };
 	private:
-		static void set_viewport_scissor(vk::CommandBuffer command_buffer, glm::ivec2 framebuffer_size);
-		
-		static void set_static_states(vk::CommandBuffer command_buffer);
-		void set_common_states(vk::CommandBuffer command_buffer) const;
-		void set_vertex_states(vk::CommandBuffer command_buffer) const;
-		void set_fragment_states(vk::CommandBuffer command_buffer) const;
-		void bind_shaders(vk::CommandBuffer command_buffer) const;
+		void set_common_states(DynamicStateCache& state_cache) const;
+		void set_vertex_states(DynamicStateCache& state_cache) const;
+		void set_fragment_states(DynamicStateCache& state_cache) const;
 
 		ShaderVertexInput m_vertex_input{};
 		std::vector<vk::UniqueShaderEXT> m_shaders{};
-
-		ScopedWaiter m_waiter{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include <compare>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace sve {
+	// Refers to a value in a SlotMap<Type>. The generation changes whenever a slot is freed,
+	// so a handle outliving its value is detected instead of aliasing whatever reuses the slot.
+	template <typename Type>
+	struct Handle {
+		auto operator<=>(Handle const& rhs) const = default;
+
+		explicit operator bool() const { return generation != 0; }
+
+		// small and stable while the value lives, fit for sort keys and GPU indices
+		std::uint32_t index{};
+		// 0 is never handed out, a default constructed handle is null
+		std::uint32_t generation{};
+	};
+
+	// Values live contiguously in insertion order with holes filled by the last value, so iteration
+	// is a linear scan. Handles go through a slot table to find their value: insert, erase and lookup
+	// are O(1), but erasing moves one value and invalidates pointers and references into the map.
+	template <typename Type>
+	class SlotMap {
+	public:
+		using HandleType = Handle<Type>;
+
+		template <typename... Args>
+		HandleType emplace(Args&&... args) {
+			auto index = std::uint32_t{};
+			if (!m_free_slots.empty()) {
+				index = m_free_slots.back();
+				m_free_slots.pop_back();
+			}
+			else {
+				index = static_cast<std::uint32_t>(m_slots.size());
+				m_slots.push_back(Slot{ .generation = 1 });
+			}
+
+			auto& slot = m_slots[index];
+			slot.dense_index = static_cast<std::uint32_t>(m_values.size());
+			m_values.emplace_back(std::forward<Args>(args)...);
+			m_dense_slots.push_back(index);
+			return HandleType{ .index = index, .generation = slot.generation };
+		}
+
+		HandleType insert(Type value) { return emplace(std::move(value)); }
+
+		// removes the value and hands it to the caller, eg to destroy it once the GPU is done with it
+		[[nodiscard]] Type take(HandleType const handle) {
+			auto const dense_index = get_slot(handle).dense_index;
+			auto ret = std::move(m_values[dense_index]);
+			remove(handle.index, dense_index);
+			return ret;
+		}
+
+		// false if the handle is stale
+		bool erase(HandleType const handle) {
+			if (!contains(handle)) return false;
+			remove(handle.index, m_slots[handle.index].dense_index);
+			return true;
+		}
+
+		[[nodiscard]] bool contains(HandleType const handle) const {
+			return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation && handle.generation != 0;
+		}
+
+		// null if the handle is stale
+		[[nodiscard]] Type* find(HandleType const handle) { return contains(handle) ? &m_values[m_slots[handle.index].dense_index] : nullptr; }
+		[[nodiscard]] Type const* find(HandleType const handle) const { return contains(handle) ? &m_values[m_slots[handle.index].dense_index] : nullptr; }
+
+		// throws std::out_of_range if the handle is stale
+		[[nodiscard]] Type& get(HandleType const handle) { return m_values[get_slot(handle).dense_index]; }
+		[[nodiscard]] Type const& get(HandleType const handle) const { return m_values[get_slot(handle).dense_index]; }
+
+		[[nodiscard]] std::span<Type> get_values() { return m_values; }
+		[[nodiscard]] std::span<Type const> get_values() const { return m_values; }
+		// handle of the value at a position of get_values()
+		[[nodiscard]] HandleType get_handle(std::size_t const dense_index) const {
+			auto const index = m_dense_slots.at(dense_index);
+			return HandleType{ .index = index, .generation = m_slots[index].generation };
+		}
+
+		[[nodiscard]] std::size_t size() const { return m_values.size(); }
+		[[nodiscard]] bool empty() const { return m_values.empty(); }
+		// one past the largest index handed out so far
+		[[nodiscard]] std::size_t get_slot_count() const { return m_slots.size(); }
+
+		void clear() {
+			while (!m_values.empty()) remove(m_dense_slots.back(), static_cast<std::uint32_t>(m_values.size() - 1));
+		}
+
+	private:
+		struct Slot {
+			std::uint32_t dense_index{};
+			std::uint32_t generation{};
+		};
+
+		[[nodiscard]] Slot const& get_slot(HandleType const handle) const {
+			if (!contains(handle)) throw std::out_of_range{ "Stale slot map handle" };
+			return m_slots[handle.index];
+		}
+
+		void remove(std::uint32_t const index, std::uint32_t const dense_index) {
+			// the last value fills the hole
+			auto const last = static_cast<std::uint32_t>(m_values.size() - 1);
+			if (dense_index != last) {
+				m_values[dense_index] = std::move(m_values[last]);
+				m_dense_slots[dense_index] = m_dense_slots[last];
+				m_slots[m_dense_slots[dense_index]].dense_index = dense_index;
+			}
+			m_values.pop_back();
+			m_dense_slots.pop_back();
+
+			auto& slot = m_slots[index];
+			if (++slot.generation == 0) slot.generation = 1;
+			m_free_slots.push_back(index);
+		}
+
+		std::vector<Type> m_values{};
+		// slot of every value, parallel to m_values
+		std::vector<std::uint32_t> m_dense_slots{};
+		std::vector<Slot> m_slots{};
+		std::vector<std::uint32_t> m_free_slots{};
+	};
+}
@@ -0,0 +1,179 @@
+#include "spatial_grid.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace sve {
+	namespace {
+		void erase_unordered(std::vector<std::uint32_t>& values, std::uint32_t const value) {
+			auto const it = std::ranges::find(values, value);
+			assert(it != values.end());
+			*it = values.back();
+			values.pop_back();
+		}
+	}
+
+	SpatialGrid::SpatialGrid(CreateInfo const& create_info) : m_inverse_cell_size(1.0f / create_info.cell_size) {}
+
+	std::uint32_t SpatialGrid::insert(Rect const& bounds, std::uint32_t const payload) {
+		auto proxy = std::uint32_t{};
+		if (!m_free_proxies.empty()) {
+			proxy = m_free_proxies.back();
+			m_free_proxies.pop_back();
+		}
+		else {
+			proxy = static_cast<std::uint32_t>(m_proxies.size());
+			m_proxies.emplace_back();
+		}
+
+		auto& entry = m_proxies[proxy];
+		entry = Proxy{
+			.bounds = bounds,
+			.cells = to_cells(bounds),
+			.payload = payload,
+			.query_stamp = m_query_stamp,
+			.alive = true
+		};
+		entry.oversized = is_oversized(entry.cells);
+		link(proxy);
+		return proxy;
+	}
+
+	void SpatialGrid::update(std::uint32_t const proxy, Rect const& bounds) {
+		auto& entry = m_proxies.at(proxy);
+		assert(entry.alive);
+		entry.bounds = bounds;
+		auto const cells = to_cells(bounds);
+		// most moves stay within the same cells
+		if (cells == entry.cells) return;
+
+		unlink(proxy);
+		entry.cells = cells;
+		entry.oversized = is_oversized(cells);
+		link(proxy);
+	}
+
+	void SpatialGrid::remove(std::uint32_t const proxy) {
+		auto& entry = m_proxies.at(proxy);
+		assert(entry.alive);
+		unlink(proxy);
+		entry.alive = false;
+		m_free_proxies.push_back(proxy);
+	}
+
+	void SpatialGrid::clear() {
+		m_cells.clear();
+		m_links.clear();
+		m_free_links = invalid_link_v;
+		m_oversized.clear();
+		m_proxies.clear();
+		m_free_proxies.clear();
+	}
+
+	void SpatialGrid::query(Rect const& rect, std::pmr::vector<std::uint32_t>& out) {
+		if (++m_query_stamp == 0) {
+			// stamp wrapped, forget every previous query
+			for (auto& proxy : m_proxies) proxy.query_stamp = 0;
+			m_query_stamp = 1;
+		}
+
+		auto const report = [&](std::uint32_t const proxy) {
+			auto& entry = m_proxies[proxy];
+			if (entry.query_stamp == m_query_stamp) return;
+			entry.query_stamp = m_query_stamp;
+			if (entry.bounds.overlaps(rect)) out.push_back(entry.payload);
+			};
+		auto const report_cell = [&](std::uint32_t const first_link) {
+			for (auto link = first_link; link != invalid_link_v; link = m_links[link].next) report(m_links[link].proxy);
+			};
+
+		auto const cells = to_cells(rect);
+		auto const cell_count = (std::int64_t{ cells.max.x } - cells.min.x + 1) * (std::int64_t{ cells.max.y } - cells.min.y + 1);
+		if (cell_count > static_cast<std::int64_t>(m_cells.size())) {
+			// the rect covers more cells than exist, walking the occupied ones is cheaper
+			for (auto const& [key, first_link] : m_cells) report_cell(first_link);
+		}
+		else {
+			for (auto y = cells.min.y; y <= cells.max.y; ++y) {
+				for (auto x = cells.min.x; x <= cells.max.x; ++x) {
+					auto const it = m_cells.find(to_key(x, y));
+					if (it == m_cells.end()) continue;
+					report_cell(it->second);
+				}
+			}
+		}
+		for (auto const proxy : m_oversized) report(proxy);
+	}
+
+	SpatialGrid::CellRange SpatialGrid::to_cells(Rect const& bounds) const {
+		// clamped so huge rects cannot overflow the cell coordinates
+		static constexpr auto limit_v = static_cast<float>(1 << 30);
+		auto const to_cell = [this](glm::vec2 const position) {
+			return glm::ivec2{ glm::clamp(glm::floor(position * m_inverse_cell_size), -limit_v, limit_v) };
+			};
+		return CellRange{ .min = to_cell(bounds.min), .max = to_cell(bounds.max) };
+	}
+
+	bool SpatialGrid::is_oversized(CellRange const& cells) {
+		auto const width = std::int64_t{ cells.max.x } - cells.min.x + 1;
+		auto const height = std::int64_t{ cells.max.y } - cells.min.y + 1;
+		return width * height > max_cells_v;
+	}
+
+	std::uint64_t SpatialGrid::to_key(int const x, int const y) {
+		return std::uint64_t{ static_cast<std::uint32_t>(x) } << 32 | static_cast<std::uint32_t>(y);
+	}
+
+	std::uint32_t SpatialGrid::allocate_link() {
+		if (m_free_links == invalid_link_v) {
+			m_links.emplace_back();
+			return static_cast<std::uint32_t>(m_links.size() - 1);
+		}
+		return std::exchange(m_free_links, m_links[m_free_links].next);
+	}
+
+	void SpatialGrid::link(std::uint32_t const proxy) {
+		auto& entry = m_proxies[proxy];
+		if (entry.oversized) {
+			m_oversized.push_back(proxy);
+			return;
+		}
+		for (auto y = entry.cells.min.y; y <= entry.cells.max.y; ++y) {
+			for (auto x = entry.cells.min.x; x <= entry.cells.max.x; ++x) {
+				auto const key = to_key(x, y);
+				auto& first_link = m_cells.try_emplace(key, invalid_link_v).first->second;
+				auto const link = allocate_link();
+				m_links[link] = CellLink{ .cell = key, .proxy = proxy, .next = first_link, .next_of_proxy = entry.first_link };
+				if (first_link != invalid_link_v) m_links[first_link].prev = link;
+				first_link = link;
+				entry.first_link = link;
+			}
+		}
+	}
+
+	void SpatialGrid::unlink(std::uint32_t const proxy) {
+		auto& entry = m_proxies[proxy];
+		if (entry.oversized) {
+			erase_unordered(m_oversized, proxy);
+			return;
+		}
+		auto link = std::exchange(entry.first_link, invalid_link_v);
+		while (link != invalid_link_v) {
+			auto& cell_link = m_links[link];
+			if (cell_link.prev != invalid_link_v) {
+				m_links[cell_link.prev].next = cell_link.next;
+			}
+			else {
+				auto const it = m_cells.find(cell_link.cell);
+				assert(it != m_cells.end() && it->second == link);
+				it->second = cell_link.next;
+			}
+			if (cell_link.next != invalid_link_v) m_links[cell_link.next].prev = cell_link.prev;
+
+			auto const next_link = cell_link.next_of_proxy;
+			cell_link = CellLink{ .next = std::exchange(m_free_links, link) };
+			link = next_link;
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "utils/rect.hpp"
+#include <glm/vec2.hpp>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace sve {
+	struct SpatialGridCreateInfo {
+		// roughly the size of a typical object, a few times smaller than the view
+		float cell_size{ 256.0f };
+	};
+
+	// Uniform grid hashed over an unbounded plane. Proxies are registered in every cell their bounds
+	// touch; moving a proxy only touches the grid when it crosses a cell border. Proxies spanning
+	// more than max_cells_v cells are kept in a separate list that every query tests.
+	// Cell memberships are pooled links shared by all cells, so once the grid has seen its largest
+	// number of memberships, moving proxies between known cells never allocates.
+	class SpatialGrid {
+	public:
+		using CreateInfo = SpatialGridCreateInfo;
+
+		static constexpr std::uint32_t invalid_proxy_v{ 0xffffffff };
+		static constexpr std::int64_t max_cells_v{ 64 };
+
+		explicit SpatialGrid(CreateInfo const& create_info = {});
+
+		[[nodiscard]] std::uint32_t insert(Rect const& bounds, std::uint32_t payload);
+		void update(std::uint32_t proxy, Rect const& bounds);
+		void remove(std::uint32_t proxy);
+		void clear();
+
+		// appends the payload of every proxy overlapping rect, each one once
+		void query(Rect const& rect, std::pmr::vector<std::uint32_t>& out);
+
+		[[nodiscard]] std::uint32_t get_payload(std::uint32_t const proxy) const { return m_proxies.at(proxy).payload; }
+		[[nodiscard]] std::size_t size() const { return m_proxies.size() - m_free_proxies.size(); }
+
+	private:
+		struct CellRange {
+			bool operator==(CellRange const& rhs) const = default;
+
+			glm::ivec2 min{};
+			glm::ivec2 max{};
+		};
+
+		static constexpr std::uint32_t invalid_link_v{ 0xffffffff };
+
+		// one cell a proxy is registered in, linked into the cell's list and the proxy's list
+		struct CellLink {
+			std::uint64_t cell{};
+			std::uint32_t proxy{};
+			// within the cell, next also chains the free links
+			std::uint32_t prev{ invalid_link_v };
+			std::uint32_t next{ invalid_link_v };
+			std::uint32_t next_of_proxy{ invalid_link_v };
+		};
+
+		struct Proxy {
+			Rect bounds{};
+			CellRange cells{};
+			std::uint32_t first_link{ invalid_link_v };
+			std::uint32_t payload{};
+			// last query that reported this proxy, filters duplicates from multi-cell proxies
+			std::uint32_t query_stamp{};
+			bool oversized{};
+			bool alive{};
+		};
+
+		struct CellHash {
+			[[nodiscard]] std::size_t operator()(std::uint64_t key) const {
+				key ^= key >> 33;
+				key *= 0xff51afd7ed558ccdull;
+				key ^= key >> 33;
+				return static_cast<std::size_t>(key);
+			}
+		};
+
+		[[nodiscard]] CellRange to_cells(Rect const& bounds) const;
+		[[nodiscard]] static bool is_oversized(CellRange const& cells);
+		[[nodiscard]] static std::uint64_t to_key(int x, int y);
+		[[nodiscard]] std::uint32_t allocate_link();
+		void link(std::uint32_t proxy);
+		void unlink(std::uint32_t proxy);
+
+		float m_inverse_cell_size{};
+		// first link of every cell ever occupied, empty cells keep their entry
+		std::unordered_map<std::uint64_t, std::uint32_t, CellHash> m_cells{};
+		std::vector<CellLink> m_links{};
+		std::uint32_t m_free_links{ invalid_link_v };
+		std::vector<std::uint32_t> m_oversized{};
+		std::vector<Proxy> m_proxies{};
+		std::vector<std::uint32_t> m_free_proxies{};
+		std::uint32_t m_query_stamp{};
+	};
+}
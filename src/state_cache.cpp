@@ -0,0 +1,95 @@
+#include "state_cache.hpp"
+
+namespace sve {
+	namespace {
+		constexpr auto to_vkbool(bool const value) {
+			return value ? vk::True : vk::False;
+		}
+
+		constexpr std::uint32_t static_state_count_v{ 10 };
+	}
+
+	void DynamicStateCache::set_viewport_scissor(glm::ivec2 const framebuffer_size) {
+		if (!update(m_framebuffer_size, framebuffer_size)) {
+			++m_counters.skipped;
+			return;
+		}
+
+		auto const fsize = glm::vec2{ framebuffer_size };
+		auto viewport = vk::Viewport{};
+
+		viewport.setX(0.0f).setY(fsize.y).setWidth(fsize.x).setHeight(-fsize.y);
+		m_command_buffer.setViewportWithCount(viewport);
+
+		auto const usize = glm::uvec2{ framebuffer_size };
+		auto const scissor = vk::Rect2D{ vk::Offset2D{}, vk::Extent2D{usize.x, usize.y} };
+		m_command_buffer.setScissorWithCount(scissor);
+		++m_counters.emitted;
+	}
+
+	void DynamicStateCache::set_static_states() {
+		if (m_static_states) {
+			m_counters.skipped += static_state_count_v;
+			return;
+		}
+
+		m_command_buffer.setRasterizerDiscardEnable(vk::False);
+		m_command_buffer.setRasterizationSamplesEXT(vk::SampleCountFlagBits::e1);
+		m_command_buffer.setSampleMaskEXT(vk::SampleCountFlagBits::e1, 0xff);
+		m_command_buffer.setAlphaToCoverageEnableEXT(vk::False);
+		m_command_buffer.setCullMode(vk::CullModeFlagBits::eNone);
+		m_command_buffer.setFrontFace(vk::FrontFace::eCounterClockwise);
+		m_command_buffer.setDepthBiasEnable(vk::False);
+		m_command_buffer.setStencilTestEnable(vk::False);
+		m_command_buffer.setPrimitiveRestartEnable(vk::False);
+		m_command_buffer.setColorWriteMaskEXT(0, ~vk::ColorComponentFlags{});
+		m_counters.emitted += static_state_count_v;
+		m_static_states = true;
+	}
+
+	void DynamicStateCache::set_depth(bool const test_and_write, vk::CompareOp const compare_op) {
+		auto const depth_test = to_vkbool(test_and_write);
+		if (update(m_depth_write, depth_test)) m_command_buffer.setDepthWriteEnable(depth_test);
+		if (update(m_depth_test, depth_test)) m_command_buffer.setDepthTestEnable(depth_test);
+		if (update(m_depth_compare_op, compare_op)) m_command_buffer.setDepthCompareOp(compare_op);
+	}
+
+	void DynamicStateCache::set_polygon_mode(vk::PolygonMode const polygon_mode) {
+		if (update(m_polygon_mode, polygon_mode)) m_command_buffer.setPolygonModeEXT(polygon_mode);
+	}
+
+	void DynamicStateCache::set_line_width(float const line_width) {
+		if (update(m_line_width, line_width)) m_command_buffer.setLineWidth(line_width);
+	}
+
+	void DynamicStateCache::set_vertex_input(ShaderVertexInput const& vertex_input) {
+		// the descriptions are constexpr arrays in practice, so identity is a sufficient comparison
+		auto const key = VertexInputKey{
+			.attributes = vertex_input.attributes.data(),
+			.attribute_count = vertex_input.attributes.size(),
+			.bindings = vertex_input.bindings.data(),
+			.binding_count = vertex_input.bindings.size()
+		};
+		if (update(m_vertex_input, key)) m_command_buffer.setVertexInputEXT(vertex_input.bindings, vertex_input.attributes);
+	}
+
+	void DynamicStateCache::set_topology(vk::PrimitiveTopology const topology) {
+		if (update(m_topology, topology)) m_command_buffer.setPrimitiveTopology(topology);
+	}
+
+	void DynamicStateCache::set_blend(bool const enable, vk::ColorBlendEquationEXT const& equation) {
+		auto const alpha_blend = to_vkbool(enable);
+		if (update(m_blend_enable, alpha_blend)) m_command_buffer.setColorBlendEnableEXT(0, alpha_blend);
+		if (update(m_blend_equation, equation)) m_command_buffer.setColorBlendEquationEXT(0, equation);
+	}
+
+	void DynamicStateCache::bind_shaders(vk::ShaderEXT const vertex, vk::ShaderEXT const fragment) {
+		static constexpr auto stages_v = std::array{
+			vk::ShaderStageFlagBits::eVertex,
+			vk::ShaderStageFlagBits::eFragment
+		};
+
+		auto const shaders = std::array{ vertex, fragment };
+		if (update(m_shaders, shaders)) m_command_buffer.bindShadersEXT(stages_v, shaders);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "shader_program.hpp"
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <optional>
+
+namespace sve {
+	struct StateCounters {
+		std::uint32_t emitted{};
+		std::uint32_t skipped{};
+
+		StateCounters& operator+=(StateCounters const& rhs) {
+			emitted += rhs.emitted;
+			skipped += rhs.skipped;
+			return *this;
+		}
+	};
+
+	// Remembers the dynamic state recorded into one command buffer and only emits
+	// the vkCmdSet*/bindShadersEXT calls whose values differ from what is already set.
+	class DynamicStateCache {
+	public:
+		explicit DynamicStateCache(vk::CommandBuffer command_buffer) : m_command_buffer(command_buffer) {}
+
+		[[nodiscard]] vk::CommandBuffer get_command_buffer() const { return m_command_buffer; }
+		[[nodiscard]] StateCounters const& get_counters() const { return m_counters; }
+
+		void set_viewport_scissor(glm::ivec2 framebuffer_size);
+		void set_static_states();
+		void set_depth(bool test_and_write, vk::CompareOp compare_op);
+		void set_polygon_mode(vk::PolygonMode polygon_mode);
+		void set_line_width(float line_width);
+		void set_vertex_input(ShaderVertexInput const& vertex_input);
+		void set_topology(vk::PrimitiveTopology topology);
+		void set_blend(bool enable, vk::ColorBlendEquationEXT const& equation);
+		void bind_shaders(vk::ShaderEXT vertex, vk::ShaderEXT fragment);
+
+	private:
+		template <typename Type>
+		[[nodiscard]] bool update(std::optional<Type>& cached, Type const& value) {
+			if (cached && *cached == value) {
+				++m_counters.skipped;
+				return false;
+			}
+			cached = value;
+			++m_counters.emitted;
+			return true;
+		}
+
+		struct VertexInputKey {
+			bool operator==(VertexInputKey const& rhs) const = default;
+
+			void const* attributes{};
+			std::size_t attribute_count{};
+			void const* bindings{};
+			std::size_t binding_count{};
+		};
+
+		vk::CommandBuffer m_command_buffer{};
+		StateCounters m_counters{};
+
+		bool m_static_states{};
+		std::optional<glm::ivec2> m_framebuffer_size{};
+		std::optional<vk::Bool32> m_depth_test{};
+		std::optional<vk::Bool32> m_depth_write{};
+		std::optional<vk::CompareOp> m_depth_compare_op{};
+		std::optional<vk::PolygonMode> m_polygon_mode{};
+		std::optional<float> m_line_width{};
+		std::optional<VertexInputKey> m_vertex_input{};
+		std::optional<vk::PrimitiveTopology> m_topology{};
+		std::optional<vk::Bool32> m_blend_enable{};
+		std::optional<vk::ColorBlendEquationEXT> m_blend_equation{};
+		std::optional<std::array<vk::ShaderEXT, 2>> m_shaders{};
+	};
+}
@@ -1,7 +1,9 @@
 #include "swapchain.hpp"
 #include "gpu.hpp"
+#include <algorithm>
 #include <span>
 #include <print>
+#include <vector>
 
 namespace sve {
 	namespace {
@@ -9,7 +11,16 @@ namespace sve {
 			vk::Format::eR8G8B8A8Srgb,
 			vk::Format::eB8G8R8A8Srgb,
 		};
+		// the shared refresh modes need different image usage and acquire/present rules, never offered
+		constexpr auto present_modes_v = std::array{
+			vk::PresentModeKHR::eFifo,
+			vk::PresentModeKHR::eFifoRelaxed,
+			vk::PresentModeKHR::eMailbox,
+			vk::PresentModeKHR::eImmediate,
+		};
 		constexpr std::uint32_t min_images_v{ 3 };
+		// one image on screen and one being rendered, nothing queued behind them
+		constexpr std::uint32_t low_latency_images_v{ 2 };
 
 		constexpr auto subresource_range_v = [] {
 			auto ret = vk::ImageSubresourceRange{};
@@ -44,11 +55,12 @@ namespace sve {
 			return vk::Extent2D{ x, y }; 
 		}
 
-		[[nodiscard]] constexpr std::uint32_t get_image_count(vk::SurfaceCapabilitiesKHR const& capabilities) {
+		[[nodiscard]] constexpr std::uint32_t get_image_count(vk::SurfaceCapabilitiesKHR const& capabilities, bool const low_latency) {
+			auto const desired = low_latency ? low_latency_images_v : min_images_v;
 			if (capabilities.maxImageCount < capabilities.minImageCount) {
-				return std::max(min_images_v, capabilities.minImageCount);
+				return std::max(desired, capabilities.minImageCount);
 			}
-			return std::clamp(min_images_v, capabilities.minImageCount, capabilities.maxImageCount);
+			return std::clamp(desired, capabilities.minImageCount, capabilities.maxImageCount);
 		}
 
 		void require_success(vk::Result const result, char const* error_msg) {
@@ -66,42 +78,71 @@ namespace sve {
 		}
 
 	}
-	Swapchain::Swapchain(vk::Device const device, Gpu const& gpu, vk::SurfaceKHR const surface, glm::ivec2 const size) : m_device(device), m_gpu(gpu) {
+	Swapchain::Swapchain(vk::Device const device, Gpu const& gpu, vk::SurfaceKHR const surface, glm::ivec2 const size, bool const present_wait)
+		: m_device(device), m_gpu(gpu), m_present_wait(present_wait) {
 		auto const surface_format = get_surface_format(m_gpu.device.getSurfaceFormatsKHR(surface));
+		m_present_modes = m_gpu.device.getSurfacePresentModesKHR(surface);
+		std::erase_if(m_present_modes, [](vk::PresentModeKHR const mode) { return std::ranges::find(present_modes_v, mode) == present_modes_v.end(); });
 		m_ci.setSurface(surface)
 			.setImageFormat(surface_format.format)
 			.setImageColorSpace(surface_format.colorSpace)
 			.setImageArrayLayers(1)
 			.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment)
-			.setPresentMode(vk::PresentModeKHR::eMailbox);
+			.setPresentMode(vk::PresentModeKHR::eFifo);
+		set_present_mode(vk::PresentModeKHR::eMailbox);
 		if (!recreate(size)) {
 			throw std::runtime_error{ "Failed to create Vulkan swapchain" };
 		}
 	}
 
-	bool Swapchain::recreate(glm::ivec2 size) {
+	bool Swapchain::recreate(glm::ivec2 size, std::uint64_t const retire_value) {
 		if (size.x <= 0 || size.y <= 0) return false;
+		assert(!m_image_index);
 
 		auto const capabilities = m_gpu.device.getSurfaceCapabilitiesKHR(m_ci.surface);
 		m_ci.setImageExtent(get_image_extent(capabilities, size))
-			.setMinImageCount(get_image_count(capabilities))
+			.setMinImageCount(get_image_count(capabilities, m_low_latency))
 			.setOldSwapchain(m_swapchain ? *m_swapchain : vk::SwapchainKHR{})
 			.setQueueFamilyIndices(m_gpu.queue_family);
-		assert(m_ci.imageExtent.width > 0 && m_ci.imageExtent.height > 0 && m_ci.minImageCount >= min_images_v);
-		
-		m_device.waitIdle();
-		m_swapchain = m_device.createSwapchainKHRUnique(m_ci);
+		assert(m_ci.imageExtent.width > 0 && m_ci.imageExtent.height > 0);
+
+		auto swapchain = m_device.createSwapchainKHRUnique(m_ci);
+		if (m_swapchain) {
+			// views go before the swapchain that owns their images
+			m_retired.push(retire_value, std::move(m_image_views));
+			m_retired.push(retire_value, std::move(m_present_semaphores));
+			m_retired.push(retire_value, std::move(m_swapchain));
+		}
+		m_swapchain = std::move(swapchain);
 
 		populate_images();
 		create_image_views();
 		create_present_semaphores();
 
+		m_stale = false;
+
 		size = get_size();
-		std::println("[sve] Swapchain [{}x{}]", size.x, size.y);
+		std::println(stderr, "[sve] Swapchain [{}x{}] {} x{}", size.x, size.y, vk::to_string(m_ci.presentMode), m_images.size());
+
+		return true;
+	}
 
+	bool Swapchain::set_present_mode(vk::PresentModeKHR const mode) {
+		if (std::ranges::find(m_present_modes, mode) == m_present_modes.end()) return false;
+		m_stale |= mode != m_ci.presentMode;
+		m_ci.setPresentMode(mode);
 		return true;
 	}
 
+	void Swapchain::set_low_latency(bool const low_latency) {
+		m_stale |= low_latency != m_low_latency;
+		m_low_latency = low_latency;
+	}
+
+	void Swapchain::collect_retired(std::uint64_t const completed_value) {
+		m_retired.collect(completed_value);
+	}
+
 	void Swapchain::create_present_semaphores() {
 		m_present_semaphores.clear();
 		m_present_semaphores.resize(m_images.size());
@@ -165,11 +206,26 @@ namespace sve {
 		present_info.setSwapchains(*m_swapchain)
 			.setImageIndices(image_index)
 			.setWaitSemaphores(wait_semaphore);
+		auto present_id_info = vk::PresentIdKHR{};
+		if (m_present_wait) {
+			++m_present_id;
+			present_id_info.setPresentIds(m_present_id);
+			present_info.setPNext(&present_id_info);
+		}
 		auto const result = queue.presentKHR(&present_info);
 		m_image_index.reset();
 		return !needs_recreation(result);
 	}
 
+	bool Swapchain::wait_for_present(std::uint64_t const present_id, std::chrono::nanoseconds const timeout) const {
+		if (!m_present_wait || present_id == 0) return true;
+		// the C entry point, vulkan.hpp would throw on out of date which only means the present is gone
+		auto const result = static_cast<vk::Result>(VULKAN_HPP_DEFAULT_DISPATCHER.vkWaitForPresentKHR(
+			m_device, *m_swapchain, present_id, static_cast<std::uint64_t>(timeout.count())
+		));
+		return result != vk::Result::eTimeout;
+	}
+
 	auto Swapchain::base_barrier() const -> vk::ImageMemoryBarrier2 {
 		auto ret = vk::ImageMemoryBarrier2{};
 		ret.setImage(m_images.at(m_image_index.value()))
@@ -1,15 +1,23 @@
 #pragma once
 #include "gpu.hpp"
+#include "deletion_queue.hpp"
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
+#include <chrono>
+#include <span>
 #include <render_target.hpp>
 
 namespace sve {
 	class Swapchain {
 	public:
-		explicit Swapchain(vk::Device device, Gpu const& gpu, vk::SurfaceKHR surface, glm::ivec2 size);
+		// present_wait: VK_KHR_present_id and VK_KHR_present_wait are enabled on the device
+		explicit Swapchain(vk::Device device, Gpu const& gpu, vk::SurfaceKHR surface, glm::ivec2 size, bool present_wait = false);
 
-		bool recreate(glm::ivec2 size);
+		// does not wait for the GPU, the previous swapchain is retired until the timeline reaches retire_value
+		bool recreate(glm::ivec2 size, std::uint64_t retire_value = 0);
+		// destroys retired swapchains whose last frame has completed
+		void collect_retired(std::uint64_t completed_value);
+		[[nodiscard]] std::size_t get_retired_count() const { return m_retired.size(); }
 
 		[[nodiscard]] glm::ivec2 get_size() const {
 			return { m_ci.imageExtent.width, m_ci.imageExtent.height };
@@ -18,11 +26,28 @@ namespace sve {
 			return m_ci.imageFormat;
 		}
 
+		// the surface's modes out of FIFO, FIFO relaxed, mailbox and immediate, FIFO is always among them
+		[[nodiscard]] std::span<vk::PresentModeKHR const> get_present_modes() const { return m_present_modes; }
+		[[nodiscard]] vk::PresentModeKHR get_present_mode() const { return m_ci.presentMode; }
+		// false if the surface does not support mode, applied by the next recreate()
+		bool set_present_mode(vk::PresentModeKHR mode);
+		// keeps the fewest images the surface allows queued, applied by the next recreate()
+		void set_low_latency(bool low_latency);
+		[[nodiscard]] bool is_low_latency() const { return m_low_latency; }
+		// a setting changed and the swapchain must be recreated
+		[[nodiscard]] bool is_stale() const { return m_stale; }
+
 		[[nodiscard]] std::optional<RenderTarget> aquire_next_image(vk::Semaphore to_signal);
 		[[nodiscard]] vk::ImageMemoryBarrier2 base_barrier() const;
 
 		[[nodiscard]] vk::Semaphore get_present_semaphore() const;
 		[[nodiscard]] bool present(vk::Queue queue);
+
+		[[nodiscard]] bool has_present_wait() const { return m_present_wait; }
+		// id of the last present, 0 without present wait
+		[[nodiscard]] std::uint64_t get_present_id() const { return m_present_id; }
+		// false on timeout, ids of a replaced swapchain can no longer be waited on
+		bool wait_for_present(std::uint64_t present_id, std::chrono::nanoseconds timeout) const;
 	private:
 		void populate_images();
 		void create_image_views();
@@ -37,5 +62,14 @@ namespace sve {
 		std::vector<vk::UniqueImageView> m_image_views{};
 		std::vector<vk::UniqueSemaphore> m_present_semaphores{};
 		std::optional<std::size_t> m_image_index{};
+
+		std::vector<vk::PresentModeKHR> m_present_modes{};
+		bool m_present_wait{};
+		bool m_low_latency{};
+		bool m_stale{};
+		std::uint64_t m_present_id{};
+
+		// presentation may still read the old images and wait on their semaphores
+		DeletionQueue m_retired{};
 	};
 }
\ No newline at end of file
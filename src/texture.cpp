@@ -18,7 +18,10 @@ namespace sve {
 			.allocator = create_info.allocator,
 			.queue_family = create_info.queue_family
 		};
-		m_image = vma::create_sampled_image(image_ci, std::move(create_info.command_block), create_info.bitmap);
+		auto const usize = glm::uvec2{ create_info.bitmap.size };
+		auto const usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+		m_image = vma::create_image(image_ci, usage, 1, vk::Format::eR8G8B8A8Srgb, vk::Extent2D{ usize.x, usize.y });
+		m_upload = create_info.uploads.write_image(m_image.get(), create_info.bitmap.bytes);
 
 		auto image_view_ci = vk::ImageViewCreateInfo{};
 		auto subresource_range = vk::ImageSubresourceRange{};
@@ -32,14 +35,23 @@ namespace sve {
 			.setSubresourceRange(subresource_range);
 		m_view = create_info.device.createImageViewUnique(image_view_ci);
 
-		m_sampler = create_info.device.createSamplerUnique(create_info.sampler);
+		m_sampler_handle = create_info.shared_sampler;
+		if (!m_sampler_handle) {
+			m_sampler = create_info.device.createSamplerUnique(create_info.sampler);
+			m_sampler_handle = *m_sampler;
+		}
+
+		m_slot = BindlessSlot{
+			.registry = &create_info.registry,
+			.index = create_info.registry.add(descriptor_info())
+		};
 	}
 
 	vk::DescriptorImageInfo Texture::descriptor_info() const {
 		auto ret = vk::DescriptorImageInfo{};
 		ret.setImageView(*m_view)
 			.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-			.setSampler(*m_sampler);
+			.setSampler(m_sampler_handle);
 		return ret;
 	}
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include <vma.hpp>
+#include "texture_registry.hpp"
+#include "upload_queue.hpp"
 
 namespace sve {
 	[[nodiscard]] constexpr auto create_sampler_ci(vk::SamplerAddressMode const wrap, vk::Filter const filter) {
@@ -19,11 +21,14 @@ namespace sve {
 
 	struct TextureCreateInfo {
 		vk::Device device;
-		VmaAllocator allocator;
+		vma::RawAllocator allocator;
 		std::uint32_t queue_family;
-		CommandBlock command_block;
+		UploadQueue& uploads;
 		Bitmap bitmap;
+		TextureRegistry& registry;
 		vk::SamplerCreateInfo sampler{ sampler_ci_v };
+		// used instead of creating one from sampler, eg a registry sampler shared by many textures
+		vk::Sampler shared_sampler{};
 	};
 
 	class Texture {
@@ -33,9 +38,17 @@ namespace sve {
 		explicit Texture(CreateInfo create_info);
 
 		[[nodiscard]] vk::DescriptorImageInfo descriptor_info() const;
+		// stable index into the bindless texture array
+		[[nodiscard]] std::uint32_t get_index() const { return m_slot.get().index; }
+		// the pixels are on the GPU once this completes
+		[[nodiscard]] UploadHandle get_upload() const { return m_upload; }
 	private:
 		vma::Image m_image{};
 		vk::UniqueImageView m_view{};
+		// null with a shared sampler
 		vk::UniqueSampler m_sampler{};
+		vk::Sampler m_sampler_handle{};
+		Scoped<BindlessSlot, BindlessSlotDeleter> m_slot{};
+		UploadHandle m_upload{};
 	};
 }
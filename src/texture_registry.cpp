@@ -0,0 +1,63 @@
+#include "texture_registry.hpp"
+
+namespace sve {
+	TextureRegistry::TextureRegistry(vk::Device const device, std::uint32_t const capacity)
+	: m_device(device), m_capacity(capacity) {
+		auto const pool_size = vk::DescriptorPoolSize{ vk::DescriptorType::eCombinedImageSampler, m_capacity };
+		auto pool_ci = vk::DescriptorPoolCreateInfo{};
+		pool_ci.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
+			.setPoolSizes(pool_size)
+			.setMaxSets(1);
+		m_pool = m_device.createDescriptorPoolUnique(pool_ci);
+
+		auto const binding = vk::DescriptorSetLayoutBinding{
+			0, vk::DescriptorType::eCombinedImageSampler, m_capacity, vk::ShaderStageFlagBits::eAllGraphics
+		};
+		static constexpr auto binding_flags_v = vk::DescriptorBindingFlags{
+			vk::DescriptorBindingFlagBits::ePartiallyBound
+			| vk::DescriptorBindingFlagBits::eUpdateAfterBind
+			| vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending
+		};
+		auto binding_flags_ci = vk::DescriptorSetLayoutBindingFlagsCreateInfo{};
+		binding_flags_ci.setBindingFlags(binding_flags_v);
+		auto set_layout_ci = vk::DescriptorSetLayoutCreateInfo{};
+		set_layout_ci.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+			.setBindings(binding)
+			.setPNext(&binding_flags_ci);
+		m_set_layout = m_device.createDescriptorSetLayoutUnique(set_layout_ci);
+
+		auto allocate_info = vk::DescriptorSetAllocateInfo{};
+		allocate_info.setDescriptorPool(*m_pool)
+			.setSetLayouts(*m_set_layout);
+		m_set = m_device.allocateDescriptorSets(allocate_info).front();
+	}
+
+	std::uint32_t TextureRegistry::add(vk::DescriptorImageInfo const& image_info) {
+		auto slot = std::uint32_t{};
+		if (!m_free_slots.empty()) {
+			slot = m_free_slots.back();
+			m_free_slots.pop_back();
+		}
+		else {
+			if (m_next_slot >= m_capacity) {
+				throw std::runtime_error{ "Texture registry is full" };
+			}
+			slot = m_next_slot++;
+		}
+
+		auto write = vk::WriteDescriptorSet{};
+		write.setDstSet(m_set)
+			.setDstBinding(0)
+			.setDstArrayElement(slot)
+			.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+			.setImageInfo(image_info);
+		m_device.updateDescriptorSets(write, {});
+
+		return slot;
+	}
+
+	void TextureRegistry::remove(std::uint32_t const slot) {
+		// the stale descriptor stays in place, partially bound arrays allow it as long as nothing samples it
+		m_free_slots.push_back(slot);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace sve {
+	// Owns a single partially bound, update-after-bind array of combined image samplers.
+	// Every texture writes its descriptor once into a stable slot, so shaders index
+	// the array directly and no per-frame descriptor updates are needed.
+	class TextureRegistry {
+	public:
+		// upper bound, clamp it to Gpu::max_bindless_textures
+		static constexpr std::uint32_t capacity_v{ 4096 };
+
+		explicit TextureRegistry(vk::Device device, std::uint32_t capacity = capacity_v);
+
+		[[nodiscard]] std::uint32_t add(vk::DescriptorImageInfo const& image_info);
+		void remove(std::uint32_t slot);
+
+		[[nodiscard]] vk::DescriptorSetLayout get_set_layout() const { return *m_set_layout; }
+		[[nodiscard]] vk::DescriptorSet get_set() const { return m_set; }
+		[[nodiscard]] std::uint32_t get_capacity() const { return m_capacity; }
+		[[nodiscard]] std::uint32_t get_count() const { return m_next_slot - static_cast<std::uint32_t>(m_free_slots.size()); }
+
+	private:
+		vk::Device m_device{};
+		std::uint32_t m_capacity{};
+
+		vk::UniqueDescriptorPool m_pool{};
+		vk::UniqueDescriptorSetLayout m_set_layout{};
+		vk::DescriptorSet m_set{};
+
+		std::vector<std::uint32_t> m_free_slots{};
+		std::uint32_t m_next_slot{};
+	};
+
+	struct BindlessSlot {
+		bool operator==(BindlessSlot const& rhs) const = default;
+
+		TextureRegistry* registry{};
+		std::uint32_t index{};
+	};
+
+	struct BindlessSlotDeleter {
+		void operator()(BindlessSlot const& slot) const noexcept {
+			slot.registry->remove(slot.index);
+		}
+	};
+}
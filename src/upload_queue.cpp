@@ -0,0 +1,364 @@
+#include "upload_queue.hpp"
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+namespace sve {
+	namespace {
+		// satisfies buffer to image copies of any 8, 16 or 32 bit per channel format
+		constexpr vk::DeviceSize staging_alignment_v{ 16 };
+
+		[[nodiscard]] constexpr vk::DeviceSize align_up(vk::DeviceSize const value, vk::DeviceSize const alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		constexpr auto color_subresource_range_v = [] {
+			auto ret = vk::ImageSubresourceRange{};
+			ret.setAspectMask(vk::ImageAspectFlagBits::eColor)
+				.setLayerCount(1)
+				.setLevelCount(1);
+			return ret;
+			}();
+	}
+
+	UploadQueue::UploadQueue(CreateInfo const& create_info) : m_info(create_info) {
+		if (!m_info.transfer_queue) {
+			m_info.transfer_queue = m_info.graphics_queue;
+			m_info.transfer_family = m_info.graphics_family;
+		}
+
+		auto command_pool_ci = vk::CommandPoolCreateInfo{};
+		command_pool_ci.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(m_info.transfer_family);
+		m_transfer_pool = m_info.device.createCommandPoolUnique(command_pool_ci);
+		if (has_transfer_queue()) {
+			command_pool_ci.setQueueFamilyIndex(m_info.graphics_family);
+			m_graphics_pool = m_info.device.createCommandPoolUnique(command_pool_ci);
+		}
+
+		auto semaphore_type_ci = vk::SemaphoreTypeCreateInfo{};
+		semaphore_type_ci.setSemaphoreType(vk::SemaphoreType::eTimeline);
+		auto semaphore_ci = vk::SemaphoreCreateInfo{};
+		semaphore_ci.setPNext(&semaphore_type_ci);
+		m_timeline = m_info.device.createSemaphoreUnique(semaphore_ci);
+
+		auto const staging_ci = vma::BufferCreateInfo{
+			.allocator = m_info.allocator,
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.queue_family = m_info.transfer_family
+		};
+		m_staging = vma::create_buffer(staging_ci, vma::BufferMemoryType::Host, m_info.staging_size);
+		if (!m_staging.get().buffer) {
+			throw std::runtime_error{ "Failed to create upload staging buffer" };
+		}
+	}
+
+	UploadQueue::~UploadQueue() {
+		// pending copies reference resources that may already be gone, only in-flight ones are waited for
+		auto wait_info = vk::SemaphoreWaitInfo{};
+		wait_info.setSemaphores(*m_timeline)
+			.setValues(m_submitted_value);
+		if (m_submitted_value > 0) std::ignore = m_info.device.waitSemaphores(wait_info, std::numeric_limits<std::uint64_t>::max());
+	}
+
+	UploadHandle UploadQueue::write_buffer(vk::Buffer const dst, vma::ByteSpans const& byte_spans, vk::DeviceSize const dst_offset) {
+		auto const size = std::accumulate(
+			byte_spans.begin(), byte_spans.end(), vk::DeviceSize{},
+			[](vk::DeviceSize const n, std::span<std::byte const> bytes) {
+				return n + bytes.size();
+			});
+		if (!dst || size == 0) return {};
+
+		auto const staging = allocate_staging(size);
+		auto out = staging.data;
+		for (auto const bytes : byte_spans) {
+			std::memcpy(out.data(), bytes.data(), bytes.size());
+			out = out.subspan(bytes.size());
+		}
+
+		auto const command_buffer = begin_pending();
+		auto buffer_copy = vk::BufferCopy2{};
+		buffer_copy.setSrcOffset(staging.offset)
+			.setDstOffset(dst_offset)
+			.setSize(size);
+		auto copy_buffer_info = vk::CopyBufferInfo2{};
+		copy_buffer_info.setSrcBuffer(staging.buffer)
+			.setDstBuffer(dst)
+			.setRegions(buffer_copy);
+		command_buffer.copyBuffer2(copy_buffer_info);
+
+		// within one family the timeline wait of the graphics submission makes the copy visible,
+		// across families ownership moves with a release here and an acquire at flush
+		if (has_transfer_queue()) {
+			auto barrier = vk::BufferMemoryBarrier2{};
+			barrier.setBuffer(dst)
+				.setOffset(dst_offset)
+				.setSize(size)
+				.setSrcQueueFamilyIndex(m_info.transfer_family)
+				.setDstQueueFamilyIndex(m_info.graphics_family)
+				.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+				.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+			auto dependency_info = vk::DependencyInfo{};
+			dependency_info.setBufferMemoryBarriers(barrier);
+			command_buffer.pipelineBarrier2(dependency_info);
+
+			barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eNone)
+				.setSrcAccessMask(vk::AccessFlagBits2::eNone)
+				.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+				.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead);
+			m_buffer_acquires.push_back(barrier);
+		}
+
+		++m_pending_count;
+		return UploadHandle{ get_pending_value() };
+	}
+
+	UploadHandle UploadQueue::write_image(vma::RawImage const& image, std::span<std::byte const> const bytes) {
+		if (!image.image || bytes.empty()) return {};
+
+		auto const staging = allocate_staging(bytes.size());
+		std::memcpy(staging.data.data(), bytes.data(), bytes.size());
+
+		auto const command_buffer = begin_pending();
+		auto barrier = vk::ImageMemoryBarrier2{};
+		barrier.setImage(image.image)
+			.setSubresourceRange(color_subresource_range_v)
+			.setOldLayout(vk::ImageLayout::eUndefined)
+			.setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		auto dependency_info = vk::DependencyInfo{};
+		dependency_info.setImageMemoryBarriers(barrier);
+		command_buffer.pipelineBarrier2(dependency_info);
+
+		auto subresource_layers = vk::ImageSubresourceLayers{};
+		subresource_layers.setAspectMask(vk::ImageAspectFlagBits::eColor)
+			.setLayerCount(1);
+		auto buffer_image_copy = vk::BufferImageCopy2{};
+		buffer_image_copy.setBufferOffset(staging.offset)
+			.setImageSubresource(subresource_layers)
+			.setImageExtent(vk::Extent3D{ image.extent.width, image.extent.height, 1 });
+		auto copy_info = vk::CopyBufferToImageInfo2{};
+		copy_info.setSrcBuffer(staging.buffer)
+			.setDstImage(image.image)
+			.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setRegions(buffer_image_copy);
+		command_buffer.copyBufferToImage2(copy_info);
+
+		barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+		if (has_transfer_queue()) {
+			// release here, the matching acquire is recorded on the graphics queue at flush
+			barrier.setSrcQueueFamilyIndex(m_info.transfer_family)
+				.setDstQueueFamilyIndex(m_info.graphics_family)
+				.setDstStageMask(vk::PipelineStageFlagBits2::eNone)
+				.setDstAccessMask(vk::AccessFlagBits2::eNone);
+			dependency_info.setImageMemoryBarriers(barrier);
+			command_buffer.pipelineBarrier2(dependency_info);
+
+			barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eNone)
+				.setSrcAccessMask(vk::AccessFlagBits2::eNone)
+				.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+				.setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead);
+			m_image_acquires.push_back(barrier);
+		}
+		else {
+			barrier.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+				.setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead);
+			dependency_info.setImageMemoryBarriers(barrier);
+			command_buffer.pipelineBarrier2(dependency_info);
+		}
+
+		++m_pending_count;
+		return UploadHandle{ get_pending_value() };
+	}
+
+	vma::Buffer UploadQueue::create_device_buffer(vma::BufferCreateInfo const& create_info, vma::ByteSpans const& byte_spans) {
+		auto const size = std::accumulate(
+			byte_spans.begin(), byte_spans.end(), 0uz,
+			[](std::size_t const n, std::span<std::byte const> bytes) {
+				return n + bytes.size();
+			});
+		auto ret = vma::create_buffer(create_info, vma::BufferMemoryType::Device, size);
+		std::ignore = write_buffer(ret.get().buffer, byte_spans);
+		return ret;
+	}
+
+	vma::Image UploadQueue::create_sampled_image(vma::ImageCreateInfo const& create_info, Bitmap const& bitmap) {
+		auto const usize = glm::uvec2{ bitmap.size };
+		auto const usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+		auto ret = vma::create_image(create_info, usage, 1, vk::Format::eR8G8B8A8Srgb, vk::Extent2D{ usize.x, usize.y });
+		std::ignore = write_image(ret.get(), bitmap.bytes);
+		return ret;
+	}
+
+	void UploadQueue::flush() {
+		if (!m_pending.transfer) return;
+
+		m_pending.transfer.end();
+		m_pending.value = get_pending_value();
+		if (has_transfer_queue()) {
+			submit(m_info.transfer_queue, m_pending.transfer, m_external_waits, m_pending.value - 1);
+
+			auto dependency_info = vk::DependencyInfo{};
+			dependency_info.setBufferMemoryBarriers(m_buffer_acquires)
+				.setImageMemoryBarriers(m_image_acquires);
+			auto begin_info = vk::CommandBufferBeginInfo{};
+			begin_info.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+			m_pending.graphics.begin(begin_info);
+			m_pending.graphics.pipelineBarrier2(dependency_info);
+			m_pending.graphics.end();
+			auto wait_info = vk::SemaphoreSubmitInfo{};
+			wait_info.setSemaphore(*m_timeline)
+				.setValue(m_pending.value - 1)
+				.setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+			submit(m_info.graphics_queue, m_pending.graphics, std::span{ &wait_info, 1 }, m_pending.value);
+
+			m_buffer_acquires.clear();
+			m_image_acquires.clear();
+		}
+		else {
+			submit(m_info.transfer_queue, m_pending.transfer, m_external_waits, m_pending.value);
+		}
+
+		m_external_waits.clear();
+		m_submitted_value = m_pending.value;
+		m_in_flight.push_back(std::exchange(m_pending, {}));
+		m_pending_count = 0;
+	}
+
+	void UploadQueue::wait(UploadHandle const handle) {
+		if (handle.value > m_submitted_value) flush();
+		auto wait_info = vk::SemaphoreWaitInfo{};
+		wait_info.setSemaphores(*m_timeline)
+			.setValues(handle.value);
+		std::ignore = m_info.device.waitSemaphores(wait_info, std::numeric_limits<std::uint64_t>::max());
+		reclaim();
+	}
+
+	void UploadQueue::add_wait(vk::SemaphoreSubmitInfo const& wait_info) {
+		m_external_waits.push_back(wait_info);
+	}
+
+	std::uint64_t UploadQueue::get_completed_value() const {
+		return m_info.device.getSemaphoreCounterValue(*m_timeline);
+	}
+
+	vk::SemaphoreSubmitInfo UploadQueue::get_wait_info(vk::PipelineStageFlags2 const stages) const {
+		auto ret = vk::SemaphoreSubmitInfo{};
+		ret.setSemaphore(*m_timeline)
+			.setValue(m_submitted_value)
+			.setStageMask(stages);
+		return ret;
+	}
+
+	UploadQueue::Staging UploadQueue::allocate_staging(vk::DeviceSize const size) {
+		if (size > m_info.staging_size / 2) {
+			auto const staging_ci = vma::BufferCreateInfo{
+				.allocator = m_info.allocator,
+				.usage = vk::BufferUsageFlagBits::eTransferSrc,
+				.queue_family = m_info.transfer_family
+			};
+			auto buffer = vma::create_buffer(staging_ci, vma::BufferMemoryType::Host, size);
+			if (!buffer.get().buffer) {
+				throw std::runtime_error{ "Failed to create upload staging buffer" };
+			}
+			auto ret = Staging{ .buffer = buffer.get().buffer, .data = buffer.get().mapped_span() };
+			m_oversized_staging.push(get_pending_value(), std::move(buffer));
+			return ret;
+		}
+
+		reclaim();
+		auto offset = vk::DeviceSize{};
+		while (!try_reserve(size, offset)) {
+			// the ring is full: submit what is pending, then wait for the oldest batch to free its space
+			if (m_pending.transfer) flush();
+			wait(UploadHandle{ m_in_flight.front().value });
+		}
+		return Staging{
+			.buffer = m_staging.get().buffer,
+			.offset = offset,
+			.data = m_staging.get().mapped_span().subspan(offset, size)
+		};
+	}
+
+	bool UploadQueue::try_reserve(vk::DeviceSize const size, vk::DeviceSize& out_offset) {
+		auto const capacity = m_info.staging_size;
+		if (m_staging_used == 0) m_staging_head = 0;
+
+		auto offset = align_up(m_staging_head, staging_alignment_v);
+		if (offset + size > capacity) offset = 0;
+		// wrapping wastes the end of the ring, which is only free if nothing sits in front of the head
+		auto const consumed = (offset >= m_staging_head ? offset - m_staging_head : capacity - m_staging_head) + size;
+		if (m_staging_used + consumed > capacity) return false;
+
+		m_staging_used += consumed;
+		m_pending.staging_bytes += consumed;
+		m_staging_head = offset + size;
+		out_offset = offset;
+		return true;
+	}
+
+	vk::CommandBuffer UploadQueue::begin_pending() {
+		if (m_pending.transfer) return m_pending.transfer;
+
+		if (!m_free_batches.empty()) {
+			auto const staging_bytes = m_pending.staging_bytes;
+			m_pending = m_free_batches.back();
+			m_pending.staging_bytes = staging_bytes;
+			m_free_batches.pop_back();
+		}
+		else {
+			auto allocate_info = vk::CommandBufferAllocateInfo{};
+			allocate_info.setCommandPool(*m_transfer_pool)
+				.setCommandBufferCount(1)
+				.setLevel(vk::CommandBufferLevel::ePrimary);
+			m_pending.transfer = m_info.device.allocateCommandBuffers(allocate_info).front();
+			if (has_transfer_queue()) {
+				allocate_info.setCommandPool(*m_graphics_pool);
+				m_pending.graphics = m_info.device.allocateCommandBuffers(allocate_info).front();
+			}
+		}
+
+		auto begin_info = vk::CommandBufferBeginInfo{};
+		begin_info.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+		m_pending.transfer.begin(begin_info);
+		return m_pending.transfer;
+	}
+
+	void UploadQueue::reclaim() {
+		auto const completed_value = get_completed_value();
+		while (!m_in_flight.empty() && m_in_flight.front().value <= completed_value) {
+			auto batch = m_in_flight.front();
+			m_in_flight.pop_front();
+			m_staging_used -= batch.staging_bytes;
+			batch.staging_bytes = 0;
+			// begin() implicitly resets, the pools allow per buffer resets
+			m_free_batches.push_back(batch);
+		}
+		m_oversized_staging.collect(completed_value);
+	}
+
+	void UploadQueue::submit(
+		vk::Queue const queue,
+		vk::CommandBuffer const command_buffer,
+		std::span<vk::SemaphoreSubmitInfo const> const wait_infos,
+		std::uint64_t const signal_value
+	) const {
+		auto const command_buffer_info = vk::CommandBufferSubmitInfo{ command_buffer };
+		auto signal_semaphore_info = vk::SemaphoreSubmitInfo{};
+		signal_semaphore_info.setSemaphore(*m_timeline)
+			.setValue(signal_value)
+			.setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+
+		auto submit_info = vk::SubmitInfo2{};
+		submit_info.setCommandBufferInfos(command_buffer_info)
+			.setWaitSemaphoreInfos(wait_infos)
+			.setSignalSemaphoreInfos(signal_semaphore_info);
+		queue.submit2(submit_info);
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "vma.hpp"
+#include "bitmap.hpp"
+#include "deletion_queue.hpp"
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace sve {
+	struct UploadQueueCreateInfo {
+		vk::Device device{};
+		vma::RawAllocator allocator{};
+		// queue the uploaded resources are used on
+		vk::Queue graphics_queue{};
+		std::uint32_t graphics_family{};
+		// dedicated transfer queue, the graphics queue when the device has none
+		vk::Queue transfer_queue{};
+		std::uint32_t transfer_family{};
+		vk::DeviceSize staging_size{ 32 * 1024 * 1024 };
+	};
+
+	// completes once the GPU has executed the copy and, with a dedicated transfer queue, the ownership transfer
+	struct UploadHandle {
+		std::uint64_t value{};
+	};
+
+	// Suballocates staging memory from one persistent ring and records every upload into a single
+	// command buffer, submitted by flush() and signalling a timeline semaphore.
+	// Not thread safe, flush() submits to the graphics queue so it belongs on the render thread.
+	class UploadQueue {
+	public:
+		using CreateInfo = UploadQueueCreateInfo;
+
+		explicit UploadQueue(CreateInfo const& create_info);
+		~UploadQueue();
+
+		UploadQueue(UploadQueue const&) = delete;
+		UploadQueue& operator=(UploadQueue const&) = delete;
+		UploadQueue(UploadQueue&&) = delete;
+		UploadQueue& operator=(UploadQueue&&) = delete;
+
+		// dst must have been created with eTransferDst, the spans are copied back to back
+		[[nodiscard]] UploadHandle write_buffer(vk::Buffer dst, vma::ByteSpans const& byte_spans, vk::DeviceSize dst_offset = 0);
+		// dst must be unused so far, it ends up in eShaderReadOnlyOptimal
+		[[nodiscard]] UploadHandle write_image(vma::RawImage const& image, std::span<std::byte const> bytes);
+
+		// non-blocking counterparts of vma::create_device_buffer and vma::create_sampled_image
+		[[nodiscard]] vma::Buffer create_device_buffer(vma::BufferCreateInfo const& create_info, vma::ByteSpans const& byte_spans);
+		[[nodiscard]] vma::Image create_sampled_image(vma::ImageCreateInfo const& create_info, Bitmap const& bitmap);
+
+		// submits everything written since the last flush, no-op when nothing is pending
+		void flush();
+		// flushes first if the handle is still pending
+		void wait(UploadHandle handle);
+		// the next flushed batch starts copying only once wait_info is signalled
+		void add_wait(vk::SemaphoreSubmitInfo const& wait_info);
+		[[nodiscard]] bool is_complete(UploadHandle const handle) const { return get_completed_value() >= handle.value; }
+		[[nodiscard]] std::uint64_t get_completed_value() const;
+
+		// graphics submissions waiting on this see every flushed upload
+		[[nodiscard]] vk::SemaphoreSubmitInfo get_wait_info(
+			vk::PipelineStageFlags2 stages = vk::PipelineStageFlagBits2::eAllCommands
+		) const;
+
+		[[nodiscard]] bool has_transfer_queue() const { return m_info.transfer_family != m_info.graphics_family; }
+		[[nodiscard]] std::size_t get_pending_count() const { return m_pending_count; }
+		[[nodiscard]] std::size_t get_in_flight_count() const { return m_in_flight.size(); }
+		[[nodiscard]] vk::DeviceSize get_staging_used() const { return m_staging_used; }
+		[[nodiscard]] vk::DeviceSize get_staging_size() const { return m_info.staging_size; }
+
+	private:
+		struct Staging {
+			vk::Buffer buffer{};
+			vk::DeviceSize offset{};
+			std::span<std::byte> data{};
+		};
+
+		struct Batch {
+			vk::CommandBuffer transfer{};
+			// acquires ownership on the graphics queue, only with a dedicated transfer queue
+			vk::CommandBuffer graphics{};
+			std::uint64_t value{};
+			vk::DeviceSize staging_bytes{};
+		};
+
+		// value the batch being recorded will signal once it reached the graphics queue
+		[[nodiscard]] std::uint64_t get_pending_value() const { return m_submitted_value + (has_transfer_queue() ? 2 : 1); }
+		[[nodiscard]] Staging allocate_staging(vk::DeviceSize size);
+		[[nodiscard]] bool try_reserve(vk::DeviceSize size, vk::DeviceSize& out_offset);
+		[[nodiscard]] vk::CommandBuffer begin_pending();
+		void reclaim();
+		void submit(
+			vk::Queue queue,
+			vk::CommandBuffer command_buffer,
+			std::span<vk::SemaphoreSubmitInfo const> wait_infos,
+			std::uint64_t signal_value
+		) const;
+
+		CreateInfo m_info{};
+		vk::UniqueCommandPool m_transfer_pool{};
+		vk::UniqueCommandPool m_graphics_pool{};
+		vk::UniqueSemaphore m_timeline{};
+		std::uint64_t m_submitted_value{};
+
+		vma::Buffer m_staging{};
+		vk::DeviceSize m_staging_head{};
+		vk::DeviceSize m_staging_used{};
+		// uploads too large for the ring get their own staging buffer
+		DeletionQueue m_oversized_staging{};
+
+		Batch m_pending{};
+		std::size_t m_pending_count{};
+		std::vector<vk::BufferMemoryBarrier2> m_buffer_acquires{};
+		std::vector<vk::ImageMemoryBarrier2> m_image_acquires{};
+		std::vector<vk::SemaphoreSubmitInfo> m_external_waits{};
+		std::deque<Batch> m_in_flight{};
+		std::vector<Batch> m_free_batches{};
+	};
+}
@@ -20,6 +20,10 @@ namespace sve {
 
 		constexpr Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) : r(r), g(g), b(b), a(a) {}
 
+		[[nodiscard]] constexpr std::uint32_t to_rgba8() const {
+			return std::uint32_t{ r } | std::uint32_t{ g } << 8 | std::uint32_t{ b } << 16 | std::uint32_t{ a } << 24;
+		}
+
 		vk::ClearColorValue to_vk_clear_srgb() const {
 			auto srgb_to_linear = [](float c) {
 				return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
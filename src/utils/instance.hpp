@@ -0,0 +1,25 @@
+#pragma once
+#include <glm/vec2.hpp>
+#include <cstdint>
+
+namespace sve {
+	enum class InstanceFormat : std::uint32_t { Affine, Matrix };
+
+	// 2D affine model transform plus per-instance attributes, std430 compatible.
+	// expanded to a full matrix in shader.vert, half the size of a mat4.
+	struct AffineInstance {
+		glm::vec2 x_axis{ 1.0f, 0.0f };
+		glm::vec2 y_axis{ 0.0f, 1.0f };
+		glm::vec2 translation{};
+		// sRGB RGBA8, red in the lowest byte (unpackUnorm4x8)
+		std::uint32_t color{ 0xffffffff };
+		std::uint32_t texture_index{};
+	};
+	static_assert(sizeof(AffineInstance) == 32);
+
+	// matches the push constant block of shader.vert
+	struct InstancePushConstants {
+		std::uint32_t texture_index{};
+		InstanceFormat format{};
+	};
+}
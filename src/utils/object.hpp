@@ -2,26 +2,43 @@
 #include "../vma.hpp"
 #include "../texture.hpp"
 #include "transform.hpp"
+#include "color.hpp"
+#include "rect.hpp"
 #include "../shader_program.hpp"
+#include "../spatial_grid.hpp"
+#include "../slot_map.hpp"
 
 
 namespace sve {
+	// element ranges in the renderer's GeometryArena
 	struct Mesh {
-		vma::Buffer vertex_buffer;
-		uint32_t index_count;
+		uint32_t first_vertex{};
+		uint32_t vertex_count{};
+		uint32_t first_index{};
+		uint32_t index_count{};
+		// local space bounds of the vertices, used for culling
+		Rect bounds{};
 	};
 
+	// resources are owned by the renderer's ResourceRegistry
+	using MeshHandle = Handle<Mesh>;
+	using ShaderHandle = Handle<ShaderProgram>;
+	using TextureHandle = Handle<Texture>;
+
 	struct Material {
-		ShaderProgram* shader;
-		Texture* texture;
+		ShaderHandle shader{};
+		TextureHandle texture{};
 	};
 
 	struct Object {
-		Mesh mesh;
-		Material material;
+		MeshHandle mesh{};
+		Material material{};
 		Transform transform;
+		// only applied with InstanceFormat::Affine
+		Color color{};
 
-		uint32_t texture_index{};
 		uint32_t instance_count = 1;
+		// set while the object is retained by the renderer's spatial index
+		uint32_t proxy = SpatialGrid::invalid_proxy_v;
 	};
 }
\ No newline at end of file
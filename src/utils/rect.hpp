@@ -0,0 +1,34 @@
+#pragma once
+#include "transform.hpp"
+#include <glm/common.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/vec2.hpp>
+
+namespace sve {
+	// axis aligned rectangle in 2D space
+	struct Rect {
+		glm::vec2 min{};
+		glm::vec2 max{};
+
+		[[nodiscard]] glm::vec2 center() const { return 0.5f * (min + max); }
+		[[nodiscard]] glm::vec2 half_extent() const { return 0.5f * (max - min); }
+
+		[[nodiscard]] bool overlaps(Rect const& rhs) const {
+			return min.x <= rhs.max.x && rhs.min.x <= max.x && min.y <= rhs.max.y && rhs.min.y <= max.y;
+		}
+	};
+
+	// bounds of a local rect after transform.model_matrix()
+	[[nodiscard]] inline Rect transform_bounds(Transform const& transform, Rect const& local) {
+		auto const radians = glm::radians(transform.rotation);
+		auto const s = glm::sin(radians);
+		auto const c = glm::cos(radians);
+		auto const x_axis = glm::vec2{ c, s } * transform.scale.x;
+		auto const y_axis = glm::vec2{ -s, c } * transform.scale.y;
+		auto const local_center = local.center();
+		auto const local_extent = local.half_extent();
+		auto const center = x_axis * local_center.x + y_axis * local_center.y + transform.position;
+		auto const extent = glm::abs(x_axis) * local_extent.x + glm::abs(y_axis) * local_extent.y;
+		return Rect{ .min = center - extent, .max = center + extent };
+	}
+}
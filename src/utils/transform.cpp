@@ -1,5 +1,6 @@
 #include "transform.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
 namespace sve {
 	namespace {
 		struct Matrices {
@@ -28,4 +29,10 @@ namespace sve {
 		auto const [t, r, s] = to_matrices(-position, -rotation, scale);
 		return r * t * s;
 	}
+
+	glm::mat4 view_projection_matrix(Transform const& view, glm::vec2 const viewport_size) {
+		auto const half_size = 0.5f * viewport_size;
+		auto const mat_projection = glm::ortho(-half_size.x, half_size.x, -half_size.y, half_size.y);
+		return mat_projection * view.view_matrix();
+	}
 }
\ No newline at end of file
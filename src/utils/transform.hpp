@@ -11,4 +11,7 @@ namespace sve {
 		[[nodiscard]] glm::mat4 model_matrix() const;
 		[[nodiscard]] glm::mat4 view_matrix() const;
 	};
+
+	// what the view UBO holds: an orthographic viewport of viewport_size pixels centred on the view
+	[[nodiscard]] glm::mat4 view_projection_matrix(Transform const& view, glm::vec2 viewport_size);
 }
\ No newline at end of file
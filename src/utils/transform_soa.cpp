@@ -0,0 +1,480 @@
+#include "transform_soa.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SVE_SIMD_AVX2
+#define SVE_SIMD_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVE_SIMD_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SVE_SIMD_NEON
+#endif
+
+namespace sve {
+	namespace {
+		static_assert(sizeof(glm::mat4) == 16 * sizeof(float));
+
+		constexpr auto deg_to_rad_v = std::numbers::pi_v<float> / 180.0f;
+		static_assert(sizeof(AffineInstance) == 8 * sizeof(float));
+
+		constexpr std::size_t floats_per_matrix_v{ 16 };
+		constexpr std::size_t floats_per_affine_v{ 8 };
+		alignas(16) constexpr auto column_2_v = std::array{ 0.0f, 0.0f, 1.0f, 0.0f };
+
+		struct SoAView {
+			float const* position_x{};
+			float const* position_y{};
+			float const* rotation{};
+			float const* scale_x{};
+			float const* scale_y{};
+		};
+
+		// per-instance attributes copied bit for bit into the affine output
+		struct AttributeView {
+			std::uint32_t const* color{};
+			std::uint32_t const* texture_index{};
+		};
+
+		// model = translate * rotate_z * scale, column major
+		void evaluate_scalar(SoAView const& in, std::size_t const first, std::size_t const count, float* out) {
+			for (auto i = 0uz; i < count; ++i, out += floats_per_matrix_v) {
+				auto const index = first + i;
+				auto const radians = in.rotation[index] * deg_to_rad_v;
+				auto const s = std::sin(radians);
+				auto const c = std::cos(radians);
+				auto const sx = in.scale_x[index];
+				auto const sy = in.scale_y[index];
+				auto const matrix = std::array{
+					c * sx, s * sx, 0.0f, 0.0f,
+					-s * sy, c * sy, 0.0f, 0.0f,
+					0.0f, 0.0f, 1.0f, 0.0f,
+					in.position_x[index], in.position_y[index], 0.0f, 1.0f
+				};
+				std::ranges::copy(matrix, out);
+			}
+		}
+
+		void evaluate_affine_scalar(
+			SoAView const& in, AttributeView const& attributes, std::size_t const first, std::size_t const count, AffineInstance* out
+		) {
+			for (auto i = 0uz; i < count; ++i) {
+				auto const index = first + i;
+				auto const radians = in.rotation[index] * deg_to_rad_v;
+				auto const s = std::sin(radians);
+				auto const c = std::cos(radians);
+				out[i] = AffineInstance{
+					.x_axis = { c * in.scale_x[index], s * in.scale_x[index] },
+					.y_axis = { -s * in.scale_y[index], c * in.scale_y[index] },
+					.translation = { in.position_x[index], in.position_y[index] },
+					.color = attributes.color[index],
+					.texture_index = attributes.texture_index[index]
+				};
+			}
+		}
+
+#if defined(SVE_SIMD_SSE)
+		struct Sse {
+			using F = __m128;
+			using I = __m128i;
+			static constexpr std::size_t width_v{ 4 };
+
+			static F load(float const* p) { return _mm_loadu_ps(p); }
+			static void store(float* p, F a) { _mm_storeu_ps(p, a); }
+			static F set1(float const v) { return _mm_set1_ps(v); }
+			static I iset1(std::int32_t const v) { return _mm_set1_epi32(v); }
+
+			static F add(F a, F b) { return _mm_add_ps(a, b); }
+			static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+			static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+			static F bit_and(F a, F b) { return _mm_and_ps(a, b); }
+			static F bit_andnot(F a, F b) { return _mm_andnot_ps(a, b); }
+			static F bit_xor(F a, F b) { return _mm_xor_ps(a, b); }
+
+			static I to_int(F a) { return _mm_cvttps_epi32(a); }
+			static F to_float(I a) { return _mm_cvtepi32_ps(a); }
+			static F as_float(I a) { return _mm_castsi128_ps(a); }
+			static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+			static I isub(I a, I b) { return _mm_sub_epi32(a, b); }
+			static I iand(I a, I b) { return _mm_and_si128(a, b); }
+			static I iandnot(I a, I b) { return _mm_andnot_si128(a, b); }
+			static I iequal_zero(I a) { return _mm_cmpeq_epi32(a, _mm_setzero_si128()); }
+			static I shift_to_sign(I a) { return _mm_slli_epi32(a, 29); }
+
+			static void transpose(F& r0, F& r1, F& r2, F& r3) { _MM_TRANSPOSE4_PS(r0, r1, r2, r3); }
+		};
+#endif
+
+#if defined(SVE_SIMD_AVX2)
+		struct Avx2 {
+			using F = __m256;
+			using I = __m256i;
+			static constexpr std::size_t width_v{ 8 };
+
+			static F load(float const* p) { return _mm256_loadu_ps(p); }
+			static F set1(float const v) { return _mm256_set1_ps(v); }
+			static I iset1(std::int32_t const v) { return _mm256_set1_epi32(v); }
+
+			static F add(F a, F b) { return _mm256_add_ps(a, b); }
+			static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+			static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+			static F bit_and(F a, F b) { return _mm256_and_ps(a, b); }
+			static F bit_andnot(F a, F b) { return _mm256_andnot_ps(a, b); }
+			static F bit_xor(F a, F b) { return _mm256_xor_ps(a, b); }
+
+			static I to_int(F a) { return _mm256_cvttps_epi32(a); }
+			static F to_float(I a) { return _mm256_cvtepi32_ps(a); }
+			static F as_float(I a) { return _mm256_castsi256_ps(a); }
+			static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+			static I isub(I a, I b) { return _mm256_sub_epi32(a, b); }
+			static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+			static I iandnot(I a, I b) { return _mm256_andnot_si256(a, b); }
+			static I iequal_zero(I a) { return _mm256_cmpeq_epi32(a, _mm256_setzero_si256()); }
+			static I shift_to_sign(I a) { return _mm256_slli_epi32(a, 29); }
+		};
+#endif
+
+#if defined(SVE_SIMD_NEON)
+		struct Neon {
+			using F = float32x4_t;
+			using I = int32x4_t;
+			static constexpr std::size_t width_v{ 4 };
+
+			static F load(float const* p) { return vld1q_f32(p); }
+			static void store(float* p, F a) { vst1q_f32(p, a); }
+			static F set1(float const v) { return vdupq_n_f32(v); }
+			static I iset1(std::int32_t const v) { return vdupq_n_s32(v); }
+
+			static F add(F a, F b) { return vaddq_f32(a, b); }
+			static F sub(F a, F b) { return vsubq_f32(a, b); }
+			static F mul(F a, F b) { return vmulq_f32(a, b); }
+			static F bit_and(F a, F b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+			static F bit_andnot(F a, F b) { return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(b), vreinterpretq_u32_f32(a))); }
+			static F bit_xor(F a, F b) { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+			static I to_int(F a) { return vcvtq_s32_f32(a); }
+			static F to_float(I a) { return vcvtq_f32_s32(a); }
+			static F as_float(I a) { return vreinterpretq_f32_s32(a); }
+			static I iadd(I a, I b) { return vaddq_s32(a, b); }
+			static I isub(I a, I b) { return vsubq_s32(a, b); }
+			static I iand(I a, I b) { return vandq_s32(a, b); }
+			static I iandnot(I a, I b) { return vbicq_s32(b, a); }
+			static I iequal_zero(I a) { return vreinterpretq_s32_u32(vceqq_s32(a, vdupq_n_s32(0))); }
+			static I shift_to_sign(I a) { return vshlq_n_s32(a, 29); }
+
+			static void transpose(F& r0, F& r1, F& r2, F& r3) {
+				auto const t01 = vtrnq_f32(r0, r1);
+				auto const t23 = vtrnq_f32(r2, r3);
+				r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+				r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+				r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+				r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+			}
+		};
+#endif
+
+		// the six non-constant entries of 2D affine model matrices, one lane per transform
+		template <typename S>
+		struct AffineLanes {
+			typename S::F m00{};
+			typename S::F m01{};
+			typename S::F m10{};
+			typename S::F m11{};
+			typename S::F tx{};
+			typename S::F ty{};
+		};
+
+		// Cephes style sincos: reduce to an octant of [0, pi/4], then evaluate the minimax polynomials
+		template <typename S>
+		void sincos(typename S::F x, typename S::F& out_sin, typename S::F& out_cos) {
+			auto const sign_mask = S::set1(-0.0f);
+			auto sign_sin = S::bit_and(x, sign_mask);
+			x = S::bit_andnot(sign_mask, x);
+
+			auto octant = S::to_int(S::mul(x, S::set1(4.0f / std::numbers::pi_v<float>)));
+			octant = S::iand(S::iadd(octant, S::iset1(1)), S::iset1(~1));
+			auto const y = S::to_float(octant);
+
+			auto const swap_sign_sin = S::as_float(S::shift_to_sign(S::iand(octant, S::iset1(4))));
+			auto const poly_mask = S::as_float(S::iequal_zero(S::iand(octant, S::iset1(2))));
+			auto const sign_cos = S::as_float(S::shift_to_sign(S::iandnot(S::isub(octant, S::iset1(2)), S::iset1(4))));
+			sign_sin = S::bit_xor(sign_sin, swap_sign_sin);
+
+			x = S::sub(x, S::mul(y, S::set1(0.78515625f)));
+			x = S::sub(x, S::mul(y, S::set1(2.4187564849853515625e-4f)));
+			x = S::sub(x, S::mul(y, S::set1(3.77489497744594108e-8f)));
+
+			auto const z = S::mul(x, x);
+			auto cos_poly = S::set1(2.443315711809948e-5f);
+			cos_poly = S::add(S::mul(cos_poly, z), S::set1(-1.388731625493765e-3f));
+			cos_poly = S::add(S::mul(cos_poly, z), S::set1(4.166664568298827e-2f));
+			cos_poly = S::mul(S::mul(cos_poly, z), z);
+			cos_poly = S::add(S::sub(cos_poly, S::mul(z, S::set1(0.5f))), S::set1(1.0f));
+
+			auto sin_poly = S::set1(-1.9515295891e-4f);
+			sin_poly = S::add(S::mul(sin_poly, z), S::set1(8.3321608736e-3f));
+			sin_poly = S::add(S::mul(sin_poly, z), S::set1(-1.6666654611e-1f));
+			sin_poly = S::add(S::mul(S::mul(sin_poly, z), x), x);
+
+			auto const sin_from_sin = S::bit_and(poly_mask, sin_poly);
+			auto const sin_from_cos = S::bit_andnot(poly_mask, cos_poly);
+			auto const cos_from_sin = S::sub(sin_poly, sin_from_sin);
+			auto const cos_from_cos = S::sub(cos_poly, sin_from_cos);
+
+			out_sin = S::bit_xor(S::add(sin_from_sin, sin_from_cos), sign_sin);
+			out_cos = S::bit_xor(S::add(cos_from_sin, cos_from_cos), sign_cos);
+		}
+
+		template <typename S>
+		[[nodiscard]] AffineLanes<S> evaluate_lanes(SoAView const& in, std::size_t const index) {
+			auto degrees = S::load(in.rotation + index);
+			// drop whole turns so the octant reduction stays precise for large angles
+			auto const turns = S::to_float(S::to_int(S::mul(degrees, S::set1(1.0f / 360.0f))));
+			degrees = S::sub(degrees, S::mul(turns, S::set1(360.0f)));
+
+			auto s = typename S::F{};
+			auto c = typename S::F{};
+			sincos<S>(S::mul(degrees, S::set1(deg_to_rad_v)), s, c);
+
+			auto const sx = S::load(in.scale_x + index);
+			auto const sy = S::load(in.scale_y + index);
+			return AffineLanes<S>{
+				.m00 = S::mul(c, sx),
+				.m01 = S::mul(s, sx),
+				.m10 = S::sub(S::set1(0.0f), S::mul(s, sy)),
+				.m11 = S::mul(c, sy),
+				.tx = S::load(in.position_x + index),
+				.ty = S::load(in.position_y + index)
+			};
+		}
+
+		// transposes 4 lanes of affine entries into 4 column major matrices
+		template <typename S>
+		void store_matrices_4(AffineLanes<S> lanes, float* out) {
+			static_assert(S::width_v == 4);
+			auto zero_a = S::set1(0.0f);
+			auto zero_b = zero_a;
+			S::transpose(lanes.m00, lanes.m01, zero_a, zero_b);
+			auto const column_0 = std::array{ lanes.m00, lanes.m01, zero_a, zero_b };
+
+			zero_a = S::set1(0.0f);
+			zero_b = zero_a;
+			S::transpose(lanes.m10, lanes.m11, zero_a, zero_b);
+			auto const column_1 = std::array{ lanes.m10, lanes.m11, zero_a, zero_b };
+
+			auto zero = S::set1(0.0f);
+			auto one = S::set1(1.0f);
+			S::transpose(lanes.tx, lanes.ty, zero, one);
+			auto const column_3 = std::array{ lanes.tx, lanes.ty, zero, one };
+
+			auto const column_2 = S::load(column_2_v.data());
+			for (auto i = 0uz; i < 4; ++i, out += floats_per_matrix_v) {
+				S::store(out, column_0[i]);
+				S::store(out + 4, column_1[i]);
+				S::store(out + 8, column_2);
+				S::store(out + 12, column_3[i]);
+			}
+		}
+
+		template <typename S>
+		void store_matrices(AffineLanes<S> const& lanes, float* out) {
+			store_matrices_4<S>(lanes, out);
+		}
+
+		// loads attribute bits into float lanes, they are only shuffled and stored, never used in arithmetic
+		template <typename S>
+		[[nodiscard]] typename S::F load_bits(std::uint32_t const* p) {
+			return S::load(static_cast<float const*>(static_cast<void const*>(p)));
+		}
+
+		// writes 4 affine instances, each as two 16 byte halves
+		template <typename S>
+		void store_affine_4(AffineLanes<S> lanes, typename S::F color, typename S::F texture_index, float* out) {
+			static_assert(S::width_v == 4);
+			S::transpose(lanes.m00, lanes.m01, lanes.m10, lanes.m11);
+			auto const axes = std::array{ lanes.m00, lanes.m01, lanes.m10, lanes.m11 };
+			S::transpose(lanes.tx, lanes.ty, color, texture_index);
+			auto const tails = std::array{ lanes.tx, lanes.ty, color, texture_index };
+			for (auto i = 0uz; i < 4; ++i, out += floats_per_affine_v) {
+				S::store(out, axes[i]);
+				S::store(out + 4, tails[i]);
+			}
+		}
+
+		template <typename S>
+		void store_affine(AffineLanes<S> const& lanes, typename S::F color, typename S::F texture_index, float* out) {
+			store_affine_4<S>(lanes, color, texture_index, out);
+		}
+
+#if defined(SVE_SIMD_AVX2)
+		template <int High>
+		[[nodiscard]] __m128 split(__m256 const v) {
+			if constexpr (High == 0) return _mm256_castps256_ps128(v);
+			else return _mm256_extractf128_ps(v, 1);
+		}
+
+		template <int High>
+		[[nodiscard]] AffineLanes<Sse> split(AffineLanes<Avx2> const& lanes) {
+			return AffineLanes<Sse>{
+				.m00 = split<High>(lanes.m00), .m01 = split<High>(lanes.m01),
+				.m10 = split<High>(lanes.m10), .m11 = split<High>(lanes.m11),
+				.tx = split<High>(lanes.tx), .ty = split<High>(lanes.ty)
+			};
+		}
+
+		template <>
+		void store_matrices<Avx2>(AffineLanes<Avx2> const& lanes, float* out) {
+			store_matrices_4<Sse>(split<0>(lanes), out);
+			store_matrices_4<Sse>(split<1>(lanes), out + 4 * floats_per_matrix_v);
+		}
+
+		template <>
+		void store_affine<Avx2>(AffineLanes<Avx2> const& lanes, __m256 const color, __m256 const texture_index, float* out) {
+			store_affine_4<Sse>(split<0>(lanes), split<0>(color), split<0>(texture_index), out);
+			store_affine_4<Sse>(split<1>(lanes), split<1>(color), split<1>(texture_index), out + 4 * floats_per_affine_v);
+		}
+#endif
+
+		template <typename S>
+		void evaluate_simd(SoAView const& in, std::size_t const first, std::size_t const count, float* out) {
+			auto i = 0uz;
+			for (; i + S::width_v <= count; i += S::width_v) {
+				store_matrices<S>(evaluate_lanes<S>(in, first + i), out + i * floats_per_matrix_v);
+			}
+			evaluate_scalar(in, first + i, count - i, out + i * floats_per_matrix_v);
+		}
+
+		template <typename S>
+		void evaluate_affine_simd(
+			SoAView const& in, AttributeView const& attributes, std::size_t const first, std::size_t const count, AffineInstance* out
+		) {
+			auto* floats = static_cast<float*>(static_cast<void*>(out));
+			auto i = 0uz;
+			for (; i + S::width_v <= count; i += S::width_v) {
+				auto const index = first + i;
+				store_affine<S>(
+					evaluate_lanes<S>(in, index),
+					load_bits<S>(attributes.color + index),
+					load_bits<S>(attributes.texture_index + index),
+					floats + i * floats_per_affine_v
+				);
+			}
+			evaluate_affine_scalar(in, attributes, first + i, count - i, out + i);
+		}
+
+		void evaluate_native(SoAView const& in, std::size_t const first, std::size_t const count, float* out) {
+#if defined(SVE_SIMD_AVX2)
+			evaluate_simd<Avx2>(in, first, count, out);
+#elif defined(SVE_SIMD_SSE)
+			evaluate_simd<Sse>(in, first, count, out);
+#elif defined(SVE_SIMD_NEON)
+			evaluate_simd<Neon>(in, first, count, out);
+#else
+			evaluate_scalar(in, first, count, out);
+#endif
+		}
+
+		void evaluate_affine_native(
+			SoAView const& in, AttributeView const& attributes, std::size_t const first, std::size_t const count, AffineInstance* out
+		) {
+#if defined(SVE_SIMD_AVX2)
+			evaluate_affine_simd<Avx2>(in, attributes, first, count, out);
+#elif defined(SVE_SIMD_SSE)
+			evaluate_affine_simd<Sse>(in, attributes, first, count, out);
+#elif defined(SVE_SIMD_NEON)
+			evaluate_affine_simd<Neon>(in, attributes, first, count, out);
+#else
+			evaluate_affine_scalar(in, attributes, first, count, out);
+#endif
+		}
+	}
+
+	void TransformSoA::clear() {
+		m_position_x.clear();
+		m_position_y.clear();
+		m_rotation.clear();
+		m_scale_x.clear();
+		m_scale_y.clear();
+	}
+
+	void TransformSoA::reserve(std::size_t const count) {
+		m_position_x.reserve(count);
+		m_position_y.reserve(count);
+		m_rotation.reserve(count);
+		m_scale_x.reserve(count);
+		m_scale_y.reserve(count);
+	}
+
+	void TransformSoA::resize(std::size_t const count) {
+		m_position_x.resize(count);
+		m_position_y.resize(count);
+		m_rotation.resize(count);
+		m_scale_x.resize(count);
+		m_scale_y.resize(count);
+	}
+
+	void TransformSoA::push_back(Transform const& transform) {
+		m_position_x.push_back(transform.position.x);
+		m_position_y.push_back(transform.position.y);
+		m_rotation.push_back(transform.rotation);
+		m_scale_x.push_back(transform.scale.x);
+		m_scale_y.push_back(transform.scale.y);
+	}
+
+	void TransformSoA::set(std::size_t const index, Transform const& transform) {
+		assert(index < size());
+		m_position_x[index] = transform.position.x;
+		m_position_y[index] = transform.position.y;
+		m_rotation[index] = transform.rotation;
+		m_scale_x[index] = transform.scale.x;
+		m_scale_y[index] = transform.scale.y;
+	}
+
+	void TransformSoA::evaluate(std::span<glm::mat4> out, std::size_t const first, TransformKernel const kernel) const {
+		assert(first + out.size() <= size());
+		auto const view = SoAView{
+			.position_x = m_position_x.data(),
+			.position_y = m_position_y.data(),
+			.rotation = m_rotation.data(),
+			.scale_x = m_scale_x.data(),
+			.scale_y = m_scale_y.data()
+		};
+		auto* floats = static_cast<float*>(static_cast<void*>(out.data()));
+		if (kernel == TransformKernel::Scalar) {
+			evaluate_scalar(view, first, out.size(), floats);
+			return;
+		}
+		evaluate_native(view, first, out.size(), floats);
+	}
+
+	void TransformSoA::evaluate(
+		std::span<AffineInstance> out,
+		std::span<std::uint32_t const> colors,
+		std::span<std::uint32_t const> texture_indices,
+		std::size_t const first,
+		TransformKernel const kernel
+	) const {
+		assert(first + out.size() <= size());
+		assert(first + out.size() <= colors.size() && first + out.size() <= texture_indices.size());
+		auto const view = SoAView{
+			.position_x = m_position_x.data(),
+			.position_y = m_position_y.data(),
+			.rotation = m_rotation.data(),
+			.scale_x = m_scale_x.data(),
+			.scale_y = m_scale_y.data()
+		};
+		auto const attributes = AttributeView{ .color = colors.data(), .texture_index = texture_indices.data() };
+		if (kernel == TransformKernel::Scalar) {
+			evaluate_affine_scalar(view, attributes, first, out.size(), out.data());
+			return;
+		}
+		evaluate_affine_native(view, attributes, first, out.size(), out.data());
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "transform.hpp"
+#include "instance.hpp"
+#include <glm/mat4x4.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sve {
+	enum class TransformKernel : std::int8_t { Simd, Scalar };
+
+	// Structure-of-arrays transform storage, evaluated in one vectorised pass
+	// (AVX2, SSE2 or NEON depending on the target, scalar otherwise).
+	class TransformSoA {
+	public:
+		void clear();
+		void reserve(std::size_t count);
+		void resize(std::size_t count);
+		void push_back(Transform const& transform);
+		void set(std::size_t index, Transform const& transform);
+
+		[[nodiscard]] std::size_t size() const { return m_rotation.size(); }
+		[[nodiscard]] bool empty() const { return m_rotation.empty(); }
+
+		// writes the model matrices of transforms [first, first + out.size())
+		void evaluate(std::span<glm::mat4> out, std::size_t first = 0, TransformKernel kernel = TransformKernel::Simd) const;
+		// same for compact instances, colors and texture_indices are indexed like the transforms
+		void evaluate(
+			std::span<AffineInstance> out,
+			std::span<std::uint32_t const> colors,
+			std::span<std::uint32_t const> texture_indices,
+			std::size_t first = 0,
+			TransformKernel kernel = TransformKernel::Simd
+		) const;
+
+	private:
+		std::vector<float> m_position_x{};
+		std::vector<float> m_position_y{};
+		std::vector<float> m_rotation{};
+		std::vector<float> m_scale_x{};
+		std::vector<float> m_scale_y{};
+	};
+}
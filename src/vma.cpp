@@ -1,16 +1,80 @@
 #define VMA_IMPLEMENTATION
 #include "vma.hpp"
-#include <numeric>
+#include "gpu.hpp"
+#include <atomic>
 #include <vk_mem_alloc.h>
 #include <print>
 
 
 namespace sve::vma {
-	void Deleter::operator()(VmaAllocator allocator) const noexcept {
-		vmaDestroyAllocator(allocator);
+	struct AllocatorState {
+		std::array<std::atomic<std::uint32_t>, memory_category_count_v> allocations{};
+		std::array<std::atomic<vk::DeviceSize>, memory_category_count_v> bytes{};
+		std::atomic<std::uint32_t> evicted_allocations{};
+		std::atomic<std::uint32_t> over_budget_allocations{};
+		EvictFunc evict{};
+	};
+
+	namespace {
+
+		[[nodiscard]] MemoryCategory to_category(vk::BufferUsageFlags const usage, BufferMemoryType const memory_type) {
+			if (memory_type == BufferMemoryType::Host && usage == vk::BufferUsageFlagBits::eTransferSrc) return MemoryCategory::Staging;
+			// indirect buffers are usually storage buffers too, the indirect use is the more telling one
+			if (usage & vk::BufferUsageFlagBits::eIndirectBuffer) return MemoryCategory::Indirect;
+			if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer)) return MemoryCategory::Geometry;
+			if (usage & vk::BufferUsageFlagBits::eUniformBuffer) return MemoryCategory::Uniform;
+			if (usage & vk::BufferUsageFlagBits::eStorageBuffer) return MemoryCategory::Storage;
+			return MemoryCategory::OtherBuffer;
+		}
+
+		// the category is kept in the allocation's user data, offset by one so untracked allocations read as 0
+		void track_allocation(RawAllocator const allocator, VmaAllocation const allocation, MemoryCategory const category) {
+			vmaSetAllocationUserData(allocator.handle, allocation, reinterpret_cast<void*>(static_cast<std::uintptr_t>(category) + 1));
+			auto* state = allocator.state;
+			if (!state) return;
+			auto allocation_info = VmaAllocationInfo{};
+			vmaGetAllocationInfo(allocator.handle, allocation, &allocation_info);
+			auto const index = static_cast<std::size_t>(category);
+			++state->allocations[index];
+			state->bytes[index] += allocation_info.size;
+		}
+
+		void untrack_allocation(RawAllocator const allocator, VmaAllocation const allocation) noexcept {
+			auto allocation_info = VmaAllocationInfo{};
+			vmaGetAllocationInfo(allocator.handle, allocation, &allocation_info);
+			auto const tag = reinterpret_cast<std::uintptr_t>(allocation_info.pUserData);
+			auto* state = allocator.state;
+			if (tag == 0 || !state) return;
+			--state->allocations[tag - 1];
+			state->bytes[tag - 1] -= allocation_info.size;
+		}
+
+		// tries within budget, then again after evicting, and finally over budget rather than failing;
+		// VMA already falls back to less preferred memory types that still have budget left
+		template <typename Func>
+		[[nodiscard]] VkResult allocate(RawAllocator const allocator, VmaAllocationCreateInfo allocation_ci, Func const& create) {
+			allocation_ci.flags |= VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+			if (create(allocation_ci) == VK_SUCCESS) return VK_SUCCESS;
+
+			auto* state = allocator.state;
+			if (state && state->evict && state->evict() && create(allocation_ci) == VK_SUCCESS) {
+				++state->evicted_allocations;
+				return VK_SUCCESS;
+			}
+
+			allocation_ci.flags &= ~VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+			auto const result = create(allocation_ci);
+			if (result == VK_SUCCESS && state) ++state->over_budget_allocations;
+			return result;
+		}
+	}
+
+	void Deleter::operator()(RawAllocator const& allocator) const noexcept {
+		vmaDestroyAllocator(allocator.handle);
+		delete allocator.state;
 	}
 
-	Allocator create_allocator(vk::Instance const instance, vk::PhysicalDevice const physical_device, vk::Device const device) {
+	Allocator create_allocator(vk::Instance const instance, vk::PhysicalDevice const physical_device, vk::Device const device, bool const memory_budget) {
 		auto const& dispatcher = VULKAN_HPP_DEFAULT_DISPATCHER;
 		auto vma_vk_funcs = VmaVulkanFunctions{};
 		vma_vk_funcs.vkGetInstanceProcAddr = dispatcher.vkGetInstanceProcAddr;
@@ -21,15 +85,64 @@ namespace sve::vma {
 		allocator_ci.device = device;
 		allocator_ci.pVulkanFunctions = &vma_vk_funcs;
 		allocator_ci.instance = instance;
-		VmaAllocator ret{};
-		auto const result = vmaCreateAllocator(&allocator_ci, &ret);
-		if (result == VK_SUCCESS) return ret;
+		allocator_ci.vulkanApiVersion = vk_version_v;
+		if (memory_budget) allocator_ci.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+		VmaAllocator handle{};
+		auto const result = vmaCreateAllocator(&allocator_ci, &handle);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error{ "Failed to create Vulkan Memory Allocator" };
+		}
+		return RawAllocator{ .handle = handle, .state = new AllocatorState{} };
+	}
 
-		throw std::runtime_error{ "Failed to create Vulkan Memory Allocator" };
+	std::string_view to_string(MemoryCategory const category) {
+		switch (category) {
+		case MemoryCategory::Staging: return "Staging";
+		case MemoryCategory::Uniform: return "Uniform";
+		case MemoryCategory::Storage: return "Storage";
+		case MemoryCategory::Geometry: return "Geometry";
+		case MemoryCategory::Indirect: return "Indirect";
+		case MemoryCategory::OtherBuffer: return "Other buffers";
+		case MemoryCategory::Image: return "Images";
+		}
+		return "Unknown";
+	}
+
+	MemoryStats get_memory_stats(RawAllocator const allocator) {
+		auto ret = MemoryStats{};
+		if (auto const* state = allocator.state) {
+			for (auto i = 0uz; i < memory_category_count_v; ++i) {
+				ret.categories[i] = CategoryStats{ .allocations = state->allocations[i], .bytes = state->bytes[i] };
+			}
+			ret.evicted_allocations = state->evicted_allocations;
+			ret.over_budget_allocations = state->over_budget_allocations;
+		}
+
+		VkPhysicalDeviceMemoryProperties const* memory_properties{};
+		vmaGetMemoryProperties(allocator.handle, &memory_properties);
+		auto budgets = std::array<VmaBudget, VK_MAX_MEMORY_HEAPS>{};
+		vmaGetHeapBudgets(allocator.handle, budgets.data());
+		ret.heap_count = memory_properties->memoryHeapCount;
+		for (auto i = 0u; i < ret.heap_count; ++i) {
+			auto const& budget = budgets[i];
+			ret.heaps[i] = HeapStats{
+				.usage = budget.usage,
+				.budget = budget.budget,
+				.block_bytes = budget.statistics.blockBytes,
+				.allocation_bytes = budget.statistics.allocationBytes,
+				.device_local = (memory_properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0
+			};
+		}
+		return ret;
+	}
+
+	void set_evict_callback(RawAllocator const allocator, EvictFunc func) {
+		if (auto* state = allocator.state) state->evict = std::move(func);
 	}
 
 	void BufferDeleter::operator()(RawBuffer const& raw_buffer) const noexcept {
-		vmaDestroyBuffer(raw_buffer.allocator, raw_buffer.buffer, raw_buffer.allocation);
+		untrack_allocation(raw_buffer.allocator, raw_buffer.allocation);
+		vmaDestroyBuffer(raw_buffer.allocator.handle, raw_buffer.buffer, raw_buffer.allocation);
 	}
 
 
@@ -44,7 +157,8 @@ namespace sve::vma {
 		auto usage = create_info.usage;
 		if (memory_type == BufferMemoryType::Device) {
 			allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-			usage |= vk::BufferUsageFlagBits::eTransferDst;
+			// transfer source so defragmentation can copy it elsewhere
+			usage |= vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
 		}
 		else {
 			allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
@@ -60,57 +174,28 @@ namespace sve::vma {
 		VmaAllocation allocation{};
 		VkBuffer buffer{};
 		auto allocation_info = VmaAllocationInfo{};
-		auto const result = vmaCreateBuffer(create_info.allocator, &vma_buffer_ci, &allocation_ci, &buffer, &allocation, &allocation_info);
+		auto const result = allocate(create_info.allocator, allocation_ci, [&](VmaAllocationCreateInfo const& ci) {
+			return vmaCreateBuffer(create_info.allocator.handle, &vma_buffer_ci, &ci, &buffer, &allocation, &allocation_info);
+			});
 		if (result != VK_SUCCESS) {
 			std::println(stderr, "Failed to create VMA buffer");
 			return{};
 		}
+		track_allocation(create_info.allocator, allocation, to_category(create_info.usage, memory_type));
 
 		return RawBuffer{
 			.allocator = create_info.allocator,
 			.allocation = allocation,
 			.buffer = buffer,
 			.size = size,
-			.mapped = allocation_info.pMappedData
+			.mapped = allocation_info.pMappedData,
+			.usage = usage
 		};
 	}
 
-	Buffer create_device_buffer(BufferCreateInfo const& create_info, CommandBlock command_block, ByteSpans const& byte_spans) {
-		auto const total_size = std::accumulate(
-			byte_spans.begin(), byte_spans.end(), 0uz,
-			[](std::size_t const n, std::span<std::byte const> bytes) {
-				return n + bytes.size();
-			});
-
-		auto staging_ci = create_info;
-		staging_ci.usage = vk::BufferUsageFlagBits::eTransferSrc;
-
-		auto staging_buffer = create_buffer(staging_ci, BufferMemoryType::Host, total_size);
-		auto ret = create_buffer(create_info, BufferMemoryType::Device, total_size);
-		if (!staging_buffer.get().buffer || !ret.get().buffer) { return {}; }
-
-		auto dst = staging_buffer.get().mapped_span();
-		for (auto const bytes : byte_spans) {
-			std::memcpy(dst.data(), bytes.data(), bytes.size());
-			dst = dst.subspan(bytes.size());
-		}
-
-		auto buffer_copy = vk::BufferCopy2{};
-		buffer_copy.setSize(total_size);
-		auto copy_buffer_info = vk::CopyBufferInfo2{};
-		copy_buffer_info.setSrcBuffer(staging_buffer.get().buffer)
-			.setDstBuffer(ret.get().buffer)
-			.setRegions(buffer_copy);
-		command_block.command_buffer().copyBuffer2(copy_buffer_info);
-
-		command_block.submit_and_wait();
-
-		return ret;
-	}
-
-
 	void ImageDeleter::operator()(RawImage const& raw_image) const noexcept {
-		vmaDestroyImage(raw_image.allocator, raw_image.image, raw_image.allocation);
+		untrack_allocation(raw_image.allocator, raw_image.allocation);
+		vmaDestroyImage(raw_image.allocator.handle, raw_image.image, raw_image.allocation);
 	}
 
 	Image create_image(ImageCreateInfo const& create_info, vk::ImageUsageFlags const usage, std::uint32_t const levels, vk::Format const format, vk::Extent2D const extent) {
@@ -136,11 +221,14 @@ namespace sve::vma {
 		allocation_ci.usage = VMA_MEMORY_USAGE_AUTO;
 		VkImage image{};
 		VmaAllocation allocation{};
-		auto const result = vmaCreateImage(create_info.allocator, &vk_image_ci, &allocation_ci, &image, &allocation, {});
+		auto const result = allocate(create_info.allocator, allocation_ci, [&](VmaAllocationCreateInfo const& ci) {
+			return vmaCreateImage(create_info.allocator.handle, &vk_image_ci, &ci, &image, &allocation, {});
+			});
 		if (result != VK_SUCCESS) {
 			std::println(stderr, "Failed to create VMA Image");
 			return {};
 		}
+		track_allocation(create_info.allocator, allocation, MemoryCategory::Image);
 
 		return RawImage{
 			.allocator = create_info.allocator,
@@ -151,72 +239,4 @@ namespace sve::vma {
 			.levels = levels
 		};
 	}
-
-	Image create_sampled_image(ImageCreateInfo const& create_info, CommandBlock command_block, Bitmap const& bitmap) {
-		auto const mip_levels = 1u;
-		auto const usize = glm::uvec2{ bitmap.size };
-		auto const extent = vk::Extent2D{ usize.x, usize.y };
-		auto const usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
-		auto ret = create_image(create_info, usage, mip_levels, vk::Format::eR8G8B8A8Srgb, extent);
-
-		auto const buffer_ci = BufferCreateInfo{
-			.allocator = create_info.allocator,
-			.usage = vk::BufferUsageFlagBits::eTransferSrc,
-			.queue_family = create_info.queue_family
-		};
-
-		auto const staging_buffer = create_buffer(buffer_ci, BufferMemoryType::Host, bitmap.bytes.size_bytes());
-
-		if (!ret.get().image || !staging_buffer.get().buffer) return {};
-
-		std::memcpy(staging_buffer.get().mapped, bitmap.bytes.data(), bitmap.bytes.size_bytes());
-
-		auto dependency_info = vk::DependencyInfo{};
-		auto subresource_range = vk::ImageSubresourceRange{};
-		subresource_range.setAspectMask(vk::ImageAspectFlagBits::eColor)
-			.setLayerCount(1)
-			.setLevelCount(mip_levels);
-		auto barrier = vk::ImageMemoryBarrier2{};
-		barrier.setImage(ret.get().image)
-			.setSrcQueueFamilyIndex(create_info.queue_family)
-			.setDstQueueFamilyIndex(create_info.queue_family)
-			.setOldLayout(vk::ImageLayout::eUndefined)
-			.setNewLayout(vk::ImageLayout::eTransferDstOptimal)
-			.setSubresourceRange(subresource_range)
-			.setSrcStageMask(vk::PipelineStageFlagBits2::eTopOfPipe)
-			.setSrcAccessMask(vk::AccessFlagBits2::eNone)
-			.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
-			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead |
-				vk::AccessFlagBits2::eMemoryWrite);
-		dependency_info.setImageMemoryBarriers(barrier);
-		command_block.command_buffer().pipelineBarrier2(dependency_info);
-
-		auto buffer_image_copy = vk::BufferImageCopy2{};
-		auto subresource_layers = vk::ImageSubresourceLayers{};
-		subresource_layers.setAspectMask(vk::ImageAspectFlagBits::eColor)
-			.setLayerCount(1)
-			.setLayerCount(mip_levels);
-		buffer_image_copy.setImageSubresource(subresource_layers)
-			.setImageExtent(vk::Extent3D{ extent.width, extent.height, 1 });
-		auto copy_info = vk::CopyBufferToImageInfo2{};
-		copy_info.setDstImage(ret.get().image)
-			.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
-			.setSrcBuffer(staging_buffer.get().buffer)
-			.setRegions(buffer_image_copy);
-		command_block.command_buffer().copyBufferToImage2(copy_info);
-
-		barrier.setOldLayout(barrier.newLayout)
-			.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-			.setSrcStageMask(barrier.dstStageMask)
-			.setSrcAccessMask(barrier.dstAccessMask)
-			.setDstStageMask(vk::PipelineStageFlagBits2::eAllGraphics)
-			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead |
-				vk::AccessFlagBits2::eMemoryWrite);
-		dependency_info.setImageMemoryBarriers(barrier);
-		command_block.command_buffer().pipelineBarrier2(dependency_info);
-
-		command_block.submit_and_wait();
-
-		return ret;
-	}
 }
\ No newline at end of file
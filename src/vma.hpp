@@ -1,19 +1,74 @@
 #pragma once
 #include "scoped.hpp"
-#include "command_block.hpp"
-#include "bitmap.hpp"
 #include <vulkan/vulkan.hpp>
 #include <vma/vk_mem_alloc.h>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string_view>
 
 namespace sve::vma {
+	// budget tracking and the evict callback of an allocator, VmaAllocator has no room for user data
+	struct AllocatorState;
+
+	// what users of an allocator hold, so buffer and image calls reach its state without a lookup
+	struct RawAllocator {
+		bool operator==(RawAllocator const& rhs) const = default;
+
+		VmaAllocator handle{};
+		AllocatorState* state{};
+	};
+
 	struct Deleter
 	{
-		void operator()(VmaAllocator allocator) const noexcept;
+		void operator()(RawAllocator const& allocator) const noexcept;
+	};
+
+	using Allocator = Scoped<RawAllocator, Deleter>;
+
+	// memory_budget: VK_EXT_memory_budget is enabled on the device, otherwise budgets are estimated from heap sizes
+	[[nodiscard]] Allocator create_allocator(vk::Instance instance, vk::PhysicalDevice physical_device, vk::Device device, bool memory_budget = false);
+
+	// what an allocation is used for, buffers are classified by their usage flags
+	enum class MemoryCategory : std::int8_t { Staging, Uniform, Storage, Geometry, Indirect, OtherBuffer, Image };
+
+	inline constexpr std::size_t memory_category_count_v{ 7 };
+
+	[[nodiscard]] std::string_view to_string(MemoryCategory category);
+
+	struct CategoryStats {
+		std::uint32_t allocations{};
+		vk::DeviceSize bytes{};
 	};
 
-	using Allocator = Scoped<VmaAllocator, Deleter>;
+	struct HeapStats {
+		// bytes used by this process and the budget it should stay within, from VK_EXT_memory_budget when enabled
+		vk::DeviceSize usage{};
+		vk::DeviceSize budget{};
+		// block bytes not covered by allocations are free or lost to fragmentation
+		vk::DeviceSize block_bytes{};
+		vk::DeviceSize allocation_bytes{};
+		bool device_local{};
+	};
+
+	struct MemoryStats {
+		std::array<CategoryStats, memory_category_count_v> categories{};
+		std::array<HeapStats, VK_MAX_MEMORY_HEAPS> heaps{};
+		std::uint32_t heap_count{};
+		// allocations that only fit the budget after evicting
+		std::uint32_t evicted_allocations{};
+		// allocations made over budget because nothing could be evicted
+		std::uint32_t over_budget_allocations{};
+	};
 
-	[[nodiscard]] Allocator create_allocator(vk::Instance instance, vk::PhysicalDevice physical_device, vk::Device device);
+	[[nodiscard]] MemoryStats get_memory_stats(RawAllocator allocator);
+
+	// called on the allocating thread when an allocation doesn't fit the budget,
+	// returns true if it released memory and the allocation is worth retrying
+	using EvictFunc = std::function<bool()>;
+
+	void set_evict_callback(RawAllocator allocator, EvictFunc func);
 
 	struct RawBuffer {
 		[[nodiscard]] std::span<std::byte> mapped_span() {
@@ -22,11 +77,13 @@ namespace sve::vma {
 
 		bool operator==(RawBuffer const& rhs) const = default;
 
-		VmaAllocator allocator{};
+		RawAllocator allocator{};
 		VmaAllocation allocation{};
 		vk::Buffer buffer{};
 		vk::DeviceSize size{};
 		void* mapped{};
+		// as created, needed to recreate the buffer when its memory is moved
+		vk::BufferUsageFlags usage{};
 	};
 
 	struct BufferDeleter {
@@ -36,7 +93,7 @@ namespace sve::vma {
 	using Buffer = Scoped<RawBuffer, BufferDeleter>;
 
 	struct BufferCreateInfo {
-		VmaAllocator allocator;
+		RawAllocator allocator;
 		vk::BufferUsageFlags usage;
 		std::uint32_t queue_family;
 	};
@@ -47,12 +104,10 @@ namespace sve::vma {
 
 	using ByteSpans = std::span<std::span<std::byte const> const>;
 
-	[[nodiscard]] Buffer create_device_buffer(BufferCreateInfo const& create_info, CommandBlock command_block, ByteSpans const& byte_spans);
-
 	struct RawImage {
 		bool operator==(RawImage const& rhs) const = default;
 
-		VmaAllocator allocator{};
+		RawAllocator allocator{};
 		VmaAllocation allocation{};
 		vk::Image image{};
 		vk::Extent2D extent{};
@@ -67,11 +122,9 @@ namespace sve::vma {
 	using Image = Scoped<RawImage, ImageDeleter>;
 
 	struct ImageCreateInfo {
-		VmaAllocator allocator{};
+		RawAllocator allocator{};
 		std::uint32_t queue_family{};
 	};
 
 	[[nodiscard]] Image create_image(ImageCreateInfo const& create_info, vk::ImageUsageFlags usage, std::uint32_t levels, vk::Format format, vk::Extent2D extent);
-
-	[[nodiscard]] Image create_sampled_image(ImageCreateInfo const& create_info, CommandBlock command_block, Bitmap const& bitmap);
 }
\ No newline at end of file